@@ -9,15 +9,24 @@
 #include <optional>
 #include <algorithm>
 #include <memory>
+#include <atomic>
+#include <string>
 
+/*
+    Reads are served from a window of the file kept in the buffer (keyed by its file offset).
+    Changing position inside the window doesn't touch the file at all, and the file is only
+    repositioned when a read actually needs bytes from outside the window.
+*/
 
 class BufferedBinaryFile {
 public:
     BufferedBinaryFile(const BufferedBinaryFile& other)=delete;
-    BufferedBinaryFile(int bufferSize=4096) :
+    static constexpr int DefaultBufferSize = 64 * 1024;
+
+    BufferedBinaryFile(int bufferSize=DefaultBufferSize) :
         buffer(bufferSize)
     {}
-    BufferedBinaryFile(const std::string& filePath, bool createFile=false, int bufferSize=4096) :
+    BufferedBinaryFile(const std::string& filePath, bool createFile=false, int bufferSize=DefaultBufferSize) :
         filePath(filePath),
         buffer(bufferSize)
     {
@@ -45,6 +54,8 @@ public:
         close();
         bufferOffset = 0;
         bufferFillSize = 0;
+        bufferFilePosition = 0;
+        filePosition = 0;
 
         if (createFile) {
             file = fopen(filePath.c_str(), "w+b");
@@ -53,10 +64,24 @@ public:
             file = fopen(filePath.c_str(), "r+b");
             currentOperation = Operation::Reading;
         }
+        if (file) {
+            // this class does all the buffering, so every fread/fwrite/fseek maps to one system call
+            setvbuf(file, nullptr, _IONBF, 0);
+        }
 
         return file;
     }
 
+    void setBufferSize(int bufferSize) {
+        if (file && currentOperation == Operation::Writing) {
+            writeBuffer();
+        }
+        bufferFilePosition += bufferOffset;
+        bufferOffset = 0;
+        bufferFillSize = 0;
+        buffer.resize(bufferSize);
+    }
+
     void clearFail() {
         failFlag = false;
     }
@@ -71,17 +96,28 @@ public:
 
     void setPosition(long newPosition) {
         if (!file) return;
-        finalizeIo();
         clearFail();
-        fseek(file, newPosition, SEEK_SET);
-        bufferOffset = 0;
-        bufferFillSize = 0;
+        if (currentOperation == Operation::Reading) {
+            if (newPosition >= bufferFilePosition && newPosition <= bufferFilePosition + bufferFillSize) {
+                bufferOffset = newPosition - bufferFilePosition;
+            } else {
+                // the file itself gets repositioned only when the next read needs it
+                bufferFilePosition = newPosition;
+                bufferOffset = 0;
+                bufferFillSize = 0;
+            }
+        } else {
+            writeBuffer();
+            seekFile(newPosition);
+        }
     }
     long getPosition() {
-        if (file) {
-            return ftell(file) - bufferFillSize + bufferOffset;
-        } else {
+        if (!file) {
             return 0;
+        } else if (currentOperation == Operation::Reading) {
+            return bufferFilePosition + bufferOffset;
+        } else {
+            return filePosition + bufferOffset;
         }
     }
 
@@ -91,6 +127,13 @@ public:
 
         int totalReadBytes = 0;
         do {
+            if (bufferOffset >= bufferFillSize && sizeInBytes - totalReadBytes >= static_cast<int>(buffer.size())) {
+                // big reads skip the buffer and go straight into the result
+                int readBytes = readDirectly(resultBuffer + totalReadBytes, sizeInBytes - totalReadBytes);
+                totalReadBytes += readBytes;
+                if (totalReadBytes < sizeInBytes) failFlag = true;
+                return totalReadBytes;
+            }
             int readBytes = readMaxPossible(resultBuffer + totalReadBytes, sizeInBytes - totalReadBytes);
             if (readBytes <= 0) {
                 return totalReadBytes;
@@ -194,6 +237,16 @@ public:
         return filePath;
     }
 
+    /*
+        Number of fread/fwrite/fseek calls done by this file (each is one system call, see open()).
+    */
+    long long getSystemCallCount() {
+        return systemCallCount;
+    }
+    static long long getTotalSystemCallCount() {
+        return totalSystemCallCount;
+    }
+
 private:
     enum class Operation {Writing, Reading};
 
@@ -221,67 +274,87 @@ private:
         if (failFlag) {
             return 0;
         }
-        if (bufferOffset + sizeInBytes > bufferFillSize) {
-            int partSize = std::max(0, static_cast<int>(bufferFillSize - bufferOffset));
-            memcpy(resultBuffer, buffer.data()+bufferOffset, partSize);
-            readBuffer();
-            return partSize;
-        } else {
-            memcpy(resultBuffer, buffer.data()+bufferOffset, sizeInBytes);
-            bufferOffset += sizeInBytes;
-            return sizeInBytes;
-        }
+        int partSize = std::min(sizeInBytes, bufferFillSize - bufferOffset);
+        memcpy(resultBuffer, buffer.data()+bufferOffset, partSize);
+        bufferOffset += partSize;
+        return partSize;
     }
 
     void switchToWriting() {
         if (currentOperation == Operation::Reading) {
-            if (bufferOffset < bufferFillSize) {
-                fseek(file, bufferOffset - bufferFillSize, SEEK_CUR);
-            }
+            // reading and writing have to be separated by a positioning call
+            forceSeekFile(bufferFilePosition + bufferOffset);
             bufferOffset = 0;
-            fflush(file);
+            bufferFillSize = 0;
             currentOperation = Operation::Writing;
         }
     }
     void switchToReading() {
         if (currentOperation == Operation::Writing) {
             writeBuffer();
+            fflush(file);
+            bufferFilePosition = filePosition;
             bufferOffset = 0;
             bufferFillSize = 0;
-            fflush(file);
             currentOperation = Operation::Reading;
         }
     }
 
-    void finalizeIo() {
-        if (currentOperation == Operation::Writing) {
-            writeBuffer();
-        } else {
-            bufferOffset = 0;
+    void seekFile(long position) {
+        if (position != filePosition) {
+            forceSeekFile(position);
         }
     }
+    void forceSeekFile(long position) {
+        fseek(file, position, SEEK_SET);
+        filePosition = position;
+        countSystemCall();
+    }
 
     bool writeBuffer() {
         if (bufferOffset > 0) {
+            countSystemCall();
             if (!fwrite(buffer.data(), bufferOffset, 1, file)) {
                 return false;
             }
+            filePosition += bufferOffset;
             bufferOffset = 0;
         }
         return true;
     }
     void readBuffer() {
-        // read only if last read buffer was full or it is first time reading after opening/changing position
-        if (bufferFillSize == 0 || bufferFillSize >= buffer.size()) {
+        // window that wasn't filled completely ended at the end of the file - no need to ask for more
+        bool atEndOfFile = bufferFillSize > 0 && bufferFillSize < static_cast<int>(buffer.size()) && bufferOffset >= bufferFillSize;
+
+        bufferFilePosition += bufferOffset;
+        bufferOffset = 0;
+        bufferFillSize = 0;
+        if (!atEndOfFile) {
+            seekFile(bufferFilePosition);
+            countSystemCall();
             bufferFillSize = static_cast<int>(fread(buffer.data(), 1, buffer.size(), file));
-        } else {
-            bufferFillSize = 0;
+            filePosition += bufferFillSize;
         }
-        bufferOffset = 0;
         if (bufferFillSize <= 0) {
             failFlag = true;
         }
     }
+    int readDirectly(char* resultBuffer, int sizeInBytes) {
+        bufferFilePosition += bufferOffset;
+        bufferOffset = 0;
+        bufferFillSize = 0;
+        seekFile(bufferFilePosition);
+        countSystemCall();
+        int readBytes = static_cast<int>(fread(resultBuffer, 1, sizeInBytes, file));
+        filePosition += readBytes;
+        bufferFilePosition += readBytes;
+        return readBytes;
+    }
+
+    void countSystemCall() {
+        systemCallCount += 1;
+        totalSystemCallCount += 1;
+    }
 
     FILE* file = nullptr;
     std::string filePath = "";
@@ -290,4 +363,8 @@ private:
     std::vector<char> buffer; 
     int bufferOffset = 0;
     int bufferFillSize = 0; // for reading only
+    long bufferFilePosition = 0; // file offset of the first byte in buffer (for reading only)
+    long filePosition = 0; // current position of the underlying FILE
+    long long systemCallCount = 0;
+    inline static std::atomic<long long> totalSystemCallCount = 0;
 };
\ No newline at end of file
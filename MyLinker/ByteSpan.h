@@ -0,0 +1,57 @@
+#pragma once
+#include "usingTypes.h"
+
+#include <cstddef>
+#include <cstring>
+
+/*
+    Non-owning view of a contiguous range of bytes (subset of C++20 std::span<const byte>).
+    The viewed memory is owned by someone else (mapped input file, read buffer, ...)
+    and has to outlive the view.
+*/
+class ByteSpan {
+public:
+    ByteSpan() = default;
+    ByteSpan(const byte* pointer, size_t length) :
+        pointer(pointer),
+        length(length)
+    {}
+
+    const byte* data() const {
+        return pointer;
+    }
+    size_t size() const {
+        return length;
+    }
+    bool empty() const {
+        return length == 0;
+    }
+
+    const byte* begin() const {
+        return pointer;
+    }
+    const byte* end() const {
+        return pointer + length;
+    }
+
+    const byte& operator[](size_t index) const {
+        return pointer[index];
+    }
+
+    ByteSpan subspan(size_t offset, size_t count) const {
+        return ByteSpan(pointer + offset, count);
+    }
+
+private:
+    const byte* pointer = nullptr;
+    size_t length = 0;
+};
+
+/*
+    Loads a little-endian value of type T stored at (possibly unaligned) bytes.
+*/
+template<typename T> T loadValue(const byte* bytes) {
+    T value;
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+}
\ No newline at end of file
@@ -0,0 +1,302 @@
+#pragma once
+#include "usingTypes.h"
+#include "ObjectFile.h"
+#include "ConcurrentSymbolTable.h"
+#include "ParallelFor.h"
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+
+/*
+    Weighted call graph of functions (code object sections) used to order them so that callers and their
+    callees end up on the same pages. Weights are numbers of call sites (there's no profile).
+
+    Functions are clustered like in C3 (call-chain clustering): going from the most called function down,
+    every function's cluster is appended to the cluster of its heaviest caller, as long as the merged cluster
+    fits in maxClusterSize bytes. Clusters are then ordered by density (call weight per byte).
+    Takes O(E log E + N log N) time for N functions and E edges.
+*/
+class CallGraph {
+public:
+    static constexpr dword InvalidNode = dword(-1);
+
+    /*
+        Adds a function of size bytes that is placed at an offset aligned to alignment (a power of 2). Its size is
+        rounded up to the alignment, so cluster sizes include the padding between the functions in them.
+    */
+    dword addNode(dword size, dword alignment = 1) {
+        nodeSizes.push_back((size + alignment - 1) & ~(alignment - 1));
+        return static_cast<dword>(nodeSizes.size() - 1);
+    }
+
+    void addEdge(dword caller, dword callee, dword weight = 1) {
+        if (caller != callee) {
+            edges.push_back({caller, callee, weight});
+        }
+    }
+
+    size_t nodeCount() const {
+        return nodeSizes.size();
+    }
+    size_t edgeCount() const {
+        return edges.size();
+    }
+
+    /*
+        Nodes in their new order. Nodes that nothing calls and that call nothing keep their relative order at the end.
+    */
+    std::vector<dword> clusterOrder(dword maxClusterSize) const {
+        size_t n = nodeSizes.size();
+
+        // merge parallel edges, then find the heaviest caller of every node (lowest caller wins ties)
+        std::vector<Edge> merged = edges;
+        std::sort(begin(merged), end(merged), [](const Edge& a, const Edge& b) {
+            return a.callee < b.callee || (a.callee == b.callee && a.caller < b.caller);
+        });
+        std::vector<qword> weights(n, 0); // all calls from and to the node
+        std::vector<dword> heaviestCaller(n, InvalidNode);
+        std::vector<qword> heaviestCallerWeight(n, 0);
+        for (size_t i = 0; i < merged.size();) {
+            auto edge = merged[i];
+            qword weight = 0;
+            for (; i < merged.size() && merged[i].caller == edge.caller && merged[i].callee == edge.callee; ++i) {
+                weight += merged[i].weight;
+            }
+            weights[edge.caller] += weight;
+            weights[edge.callee] += weight;
+            if (weight > heaviestCallerWeight[edge.callee]) {
+                heaviestCaller[edge.callee] = edge.caller;
+                heaviestCallerWeight[edge.callee] = weight;
+            }
+        }
+
+        // clusters are linked lists of nodes, with union-find to get the cluster of a node
+        std::vector<dword> parent(n);
+        std::iota(begin(parent), end(parent), 0);
+        std::vector<dword> next(n, InvalidNode);
+        std::vector<dword> tail(parent);
+        std::vector<qword> clusterSizes(begin(nodeSizes), end(nodeSizes));
+        std::vector<qword> clusterWeights(weights);
+        auto findCluster = [&](dword node) {
+            while (parent[node] != node) {
+                parent[node] = parent[parent[node]];
+                node = parent[node];
+            }
+            return node;
+        };
+
+        std::vector<dword> byWeight(n);
+        std::iota(begin(byWeight), end(byWeight), 0);
+        std::stable_sort(begin(byWeight), end(byWeight), [&](dword a, dword b) {
+            return weights[a] > weights[b];
+        });
+        for (auto callee : byWeight) {
+            if (heaviestCaller[callee] == InvalidNode) {
+                continue;
+            }
+            dword callerCluster = findCluster(heaviestCaller[callee]);
+            dword calleeCluster = findCluster(callee);
+            if (callerCluster == calleeCluster || clusterSizes[callerCluster] + clusterSizes[calleeCluster] > maxClusterSize) {
+                continue;
+            }
+            next[tail[callerCluster]] = calleeCluster;
+            tail[callerCluster] = tail[calleeCluster];
+            parent[calleeCluster] = callerCluster;
+            clusterSizes[callerCluster] += clusterSizes[calleeCluster];
+            clusterWeights[callerCluster] += clusterWeights[calleeCluster];
+        }
+
+        // densest clusters first (compared as weightA / sizeA > weightB / sizeB, empty sections count as 1 byte)
+        std::vector<dword> clusters;
+        for (dword node = 0; node < n; ++node) {
+            if (parent[node] == node) {
+                clusters.push_back(node);
+            }
+        }
+        std::stable_sort(begin(clusters), end(clusters), [&](dword a, dword b) {
+            return clusterWeights[a] * std::max<qword>(clusterSizes[b], 1) > clusterWeights[b] * std::max<qword>(clusterSizes[a], 1);
+        });
+
+        std::vector<dword> order;
+        order.reserve(n);
+        for (auto cluster : clusters) {
+            for (dword node = cluster; node != InvalidNode; node = next[node]) {
+                order.push_back(node);
+            }
+        }
+        return order;
+    }
+
+private:
+    struct Edge {
+        dword caller;
+        dword callee;
+        dword weight;
+    };
+
+    std::vector<dword> nodeSizes;
+    std::vector<Edge> edges;
+};
+
+/*
+    Relocation from a code object section (call graph node) to a place in another one.
+*/
+struct CallSite {
+    dword caller;
+    dword callerOffset; // offset of the relocated bytes in the caller
+    dword callee;
+    dword calleeOffset; // offset of the target in the callee
+};
+
+/*
+    Call graph of the code object sections of all linked object files - every code object section is a node,
+    every relative relocation (of RelocationTraits::isRelative type) to another code object section is a call edge.
+    Object sections are addressed by the index of their object file and their index in it.
+*/
+class ObjectCallGraph {
+public:
+    static constexpr dword Unranked = dword(-1);
+
+    /*
+        Where a node is placed: output section number and offset in it.
+    */
+    struct NodePosition {
+        int sectionNr = 0;
+        dword offset = 0;
+    };
+
+    template<typename RelocationTraits> void build(const std::vector<ObjectFile>& objFiles, int threadCount, dword maxClusterSize) {
+        for (size_t objNr = 0; objNr < objFiles.size(); ++objNr) {
+            auto& obj = objFiles[objNr];
+            objSectionNodes.emplace_back(obj.sections.size(), CallGraph::InvalidNode);
+            for (size_t sectionIndex = 0; sectionIndex < obj.sections.size(); ++sectionIndex) {
+                if (isCode(obj.sections[sectionIndex])) {
+                    auto& header = obj.sections[sectionIndex].header;
+                    objSectionNodes[objNr][sectionIndex] = graph.addNode(header.sizeOfRawData, header.alignment());
+                }
+            }
+        }
+
+        // functions defined by global symbols (node and offset in it), duplicates are reported by the linker later
+        ConcurrentSymbolTable<NodeOffset> symbolNameToNode;
+        parallelFor(objFiles.size(), threadCount, [&](size_t objNr) {
+            auto& obj = objFiles[objNr];
+            forEachDefinedExternal(obj, [&](size_t symbolIndex, size_t sectionIndex) {
+                if (isCode(obj.sections[sectionIndex])) {
+                    NodeOffset node{objSectionNodes[objNr][sectionIndex], obj.symbolTable.value(symbolIndex)};
+                    symbolNameToNode.insert(obj.symbolNameIds[symbolIndex], {static_cast<dword>(objNr), static_cast<dword>(symbolIndex)}, node);
+                }
+            });
+        });
+
+        std::vector<std::vector<CallSite>> objCallSites(objFiles.size());
+        parallelFor(objFiles.size(), threadCount, [&](size_t objNr) {
+            auto& obj = objFiles[objNr];
+            auto& symbols = obj.symbolTable;
+            for (size_t sectionIndex = 0; sectionIndex < obj.sections.size(); ++sectionIndex) {
+                auto& section = obj.sections[sectionIndex];
+                if (!isCode(section)) {
+                    continue;
+                }
+                for (auto& reloc : section.relocationTable) {
+                    auto symbolIndex = reloc.symbolTableIndex;
+                    if (!RelocationTraits::isRelative(reloc.type) || symbolIndex >= symbols.size() || symbols.isAuxiliary(symbolIndex)) {
+                        continue; // malformed relocations are reported later
+                    }
+                    CallSite callSite;
+                    callSite.caller = objSectionNodes[objNr][sectionIndex];
+                    callSite.callerOffset = reloc.virtualAddress;
+                    word sectionNumber = symbols.sectionNumber(symbolIndex);
+                    if (symbols.storageClass(symbolIndex) == StandardSymbol::StorageClass::External) {
+                        auto definition = symbolNameToNode.find(obj.symbolNameIds[symbolIndex]);
+                        if (!definition) {
+                            continue;
+                        }
+                        callSite.callee = definition->node;
+                        callSite.calleeOffset = definition->offset;
+                    } else if (sectionNumber > 0 && sectionNumber <= obj.sections.size() && isCode(obj.sections[sectionNumber-1])) {
+                        callSite.callee = objSectionNodes[objNr][sectionNumber-1];
+                        callSite.calleeOffset = symbols.value(symbolIndex);
+                    } else {
+                        continue;
+                    }
+                    objCallSites[objNr].push_back(callSite);
+                }
+            }
+        });
+        for (auto& sites : objCallSites) {
+            for (auto& callSite : sites) {
+                graph.addEdge(callSite.caller, callSite.callee);
+            }
+            callSites.insert(end(callSites), begin(sites), end(sites));
+        }
+
+        auto order = graph.clusterOrder(maxClusterSize);
+        nodeRanks.resize(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            nodeRanks[order[i]] = static_cast<dword>(i);
+        }
+    }
+
+    size_t nodeCount() const {
+        return graph.nodeCount();
+    }
+    size_t edgeCount() const {
+        return graph.edgeCount();
+    }
+
+    /*
+        Position of the object section in the clustered order (Unranked if it isn't a node or the graph isn't built).
+    */
+    dword rank(size_t objNr, size_t sectionIndex) const {
+        auto node = nodeOf(objNr, sectionIndex);
+        return node == CallGraph::InvalidNode ? Unranked : nodeRanks[node];
+    }
+
+    /*
+        Sets the position of the object section in positions (indexed by node) if it's a node.
+    */
+    void recordPosition(size_t objNr, size_t sectionIndex, NodePosition position, std::vector<NodePosition>& positions) const {
+        auto node = nodeOf(objNr, sectionIndex);
+        if (node != CallGraph::InvalidNode) {
+            positions[node] = position;
+        }
+    }
+
+    /*
+        Number of call sites whose caller and callee are on different pages with nodes at the given positions
+        (output sections start on separate pages).
+    */
+    size_t crossPageCalls(const std::vector<NodePosition>& positions, dword pageSize) const {
+        size_t count = 0;
+        for (auto& callSite : callSites) {
+            auto& caller = positions[callSite.caller];
+            auto& callee = positions[callSite.callee];
+            if (caller.sectionNr != callee.sectionNr
+                || (caller.offset + callSite.callerOffset) / pageSize != (callee.offset + callSite.calleeOffset) / pageSize) {
+                count += 1;
+            }
+        }
+        return count;
+    }
+
+private:
+    struct NodeOffset {
+        dword node = CallGraph::InvalidNode;
+        dword offset = 0;
+    };
+
+    static bool isCode(const ObjectSection& section) {
+        return !section.discarded && (section.header.characteristics & SectionHeader::Characteristic::ContainsCode);
+    }
+
+    dword nodeOf(size_t objNr, size_t sectionIndex) const {
+        return objNr < objSectionNodes.size() ? objSectionNodes[objNr][sectionIndex] : CallGraph::InvalidNode;
+    }
+
+    CallGraph graph;
+    std::vector<std::vector<dword>> objSectionNodes; // for every section of every object file
+    std::vector<CallSite> callSites;
+    std::vector<dword> nodeRanks;
+};
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include "usingTypes.h"
+
+#include <algorithm>
+#include <cstring>
+
+/*
+    What gaps between object sections in code are filled with.
+*/
+enum class CodePadding { Int3, Nop };
+
+/*
+    Fills size bytes of padding between object sections: code with int3 (0xCC) instructions or with
+    the longest possible multi-byte nop instructions, other sections with zeros.
+*/
+void fillPadding(byte* destination, size_t size, bool code, CodePadding codePadding) {
+    if (!code) {
+        memset(destination, 0, size);
+    } else if (codePadding == CodePadding::Int3) {
+        memset(destination, 0xCC, size);
+    } else {
+        // recommended nop encodings of lengths 1 to 9 (valid in both 32 and 64-bit mode)
+        static const byte nops[9][9] = {
+            {0x90},
+            {0x66, 0x90},
+            {0x0F, 0x1F, 0x00},
+            {0x0F, 0x1F, 0x40, 0x00},
+            {0x0F, 0x1F, 0x44, 0x00, 0x00},
+            {0x66, 0x0F, 0x1F, 0x44, 0x00, 0x00},
+            {0x0F, 0x1F, 0x80, 0x00, 0x00, 0x00, 0x00},
+            {0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+            {0x66, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},
+        };
+        while (size > 0) {
+            size_t nopSize = std::min<size_t>(size, 9);
+            memcpy(destination, nops[nopSize - 1], nopSize);
+            destination += nopSize;
+            size -= nopSize;
+        }
+    }
+}
\ No newline at end of file
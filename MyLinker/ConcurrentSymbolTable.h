@@ -0,0 +1,175 @@
+#pragma once
+#include "usingTypes.h"
+#include "SymbolInterner.h"
+
+#include <vector>
+#include <mutex>
+#include <optional>
+#include <algorithm>
+
+/*
+    Order in which a symbol definition appears in the input (object file number, then symbol number inside of it).
+    Used to make results independent of the order in which threads insert definitions.
+*/
+struct DefinitionOrder {
+    dword objNr;
+    dword symbolNr;
+
+    bool operator<(const DefinitionOrder& other) const {
+        return objNr < other.objNr || (objNr == other.objNr && symbolNr < other.symbolNr);
+    }
+
+    static constexpr DefinitionOrder none() {
+        return {dword(-1), dword(-1)};
+    }
+};
+
+/*
+    Map from symbol id to Value that many threads can insert into at once.
+    Symbols are split between independently locked shards, every shard is an open addressing
+    (linear probing) hash table of plain slots.
+
+    The value kept for a symbol is always the one of its first definition in input order, and the
+    reported duplicate is the one a serial pass over the input would have hit first - no matter which
+    thread inserted what first. Lookups are meant to happen after all insertions are done and don't lock.
+*/
+template<typename Value> class ConcurrentSymbolTable {
+public:
+    ConcurrentSymbolTable() :
+        shards(ShardCount)
+    {}
+
+    /*
+        Makes room for about symbolCount symbols up front, so shards don't have to grow while threads insert.
+    */
+    void reserve(size_t symbolCount) {
+        for (auto& shard : shards) {
+            shard.rehash(capacityFor(symbolCount / ShardCount + 1));
+        }
+    }
+
+    void insert(SymbolId id, DefinitionOrder order, const Value& value) {
+        auto& shard = shards[shardOf(id)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.slots.empty() || (shard.usedSlots + 1) * 4 > shard.slots.size() * 3) {
+            shard.rehash(std::max<size_t>(MinShardCapacity, shard.slots.size() * 2));
+        }
+        auto& slot = shard.slots[shard.findSlot(id)];
+        if (slot.id == InvalidSymbolId) {
+            slot.id = id;
+            slot.first = order;
+            slot.value = value;
+            shard.usedSlots += 1;
+        } else if (order < slot.first) {
+            slot.second = slot.first;
+            slot.first = order;
+            slot.value = value;
+        } else if (order < slot.second) {
+            slot.second = order;
+        }
+    }
+
+    const Value* find(SymbolId id) const {
+        auto& shard = shards[shardOf(id)];
+        if (shard.slots.empty()) {
+            return nullptr;
+        }
+        auto& slot = shard.slots[shard.findSlot(id)];
+        return slot.id == id ? &slot.value : nullptr;
+    }
+
+    /*
+        Symbol defined more than once whose second definition comes first in input order (if there's any).
+    */
+    std::optional<SymbolId> firstDuplicate() const {
+        std::optional<SymbolId> duplicate;
+        DefinitionOrder duplicateOrder = DefinitionOrder::none();
+        for (auto& shard : shards) {
+            for (auto& slot : shard.slots) {
+                if (slot.id != InvalidSymbolId && slot.second < duplicateOrder) {
+                    duplicate = slot.id;
+                    duplicateOrder = slot.second;
+                }
+            }
+        }
+        return duplicate;
+    }
+
+    template<typename Function> void forEachValue(Function function) {
+        for (auto& shard : shards) {
+            for (auto& slot : shard.slots) {
+                if (slot.id != InvalidSymbolId) {
+                    function(slot.value);
+                }
+            }
+        }
+    }
+
+    size_t size() const {
+        size_t count = 0;
+        for (auto& shard : shards) {
+            count += shard.usedSlots;
+        }
+        return count;
+    }
+
+private:
+    static constexpr size_t ShardCount = 64;
+    static constexpr size_t MinShardCapacity = 16;
+
+    struct Slot {
+        SymbolId id = InvalidSymbolId;
+        DefinitionOrder first = DefinitionOrder::none();
+        DefinitionOrder second = DefinitionOrder::none(); // second definition in input order (none if symbol is defined once)
+        Value value;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::vector<Slot> slots; // size is a power of 2
+        size_t usedSlots = 0;
+
+        size_t findSlot(SymbolId id) const {
+            size_t mask = slots.size() - 1;
+            size_t i = slotHash(id) & mask;
+            while (slots[i].id != InvalidSymbolId && slots[i].id != id) {
+                i = (i + 1) & mask;
+            }
+            return i;
+        }
+
+        void rehash(size_t capacity) {
+            if (capacity <= slots.size()) {
+                return;
+            }
+            std::vector<Slot> oldSlots(capacity);
+            std::swap(slots, oldSlots);
+            for (auto& slot : oldSlots) {
+                if (slot.id != InvalidSymbolId) {
+                    slots[findSlot(slot.id)] = slot;
+                }
+            }
+        }
+    };
+
+    // ids are spread by multiplicative hashing - high bits pick the shard, low bits the slot
+    static size_t mix(SymbolId id) {
+        return static_cast<dword>(id * 0x9E3779B1u);
+    }
+    static size_t shardOf(SymbolId id) {
+        return (mix(id) >> 26) % ShardCount;
+    }
+    static size_t slotHash(SymbolId id) {
+        return mix(id) & 0x3FFFFFF;
+    }
+
+    static size_t capacityFor(size_t count) {
+        size_t capacity = MinShardCapacity;
+        while (capacity * 3 < count * 4) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    std::vector<Shard> shards;
+};
\ No newline at end of file
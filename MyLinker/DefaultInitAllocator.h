@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+/*
+    Allocator that default-initializes new elements instead of value-initializing them, so resize(n) of
+    a vector of bytes leaves the new bytes as they are instead of zeroing them. Meant for buffers that are
+    overwritten right after they're allocated. resize(n, value) still fills them with value.
+*/
+template<typename T> class DefaultInitAllocator : public std::allocator<T> {
+public:
+    template<typename U> struct rebind {
+        using other = DefaultInitAllocator<U>;
+    };
+
+    DefaultInitAllocator() = default;
+    template<typename U> DefaultInitAllocator(const DefaultInitAllocator<U>& other) noexcept :
+        std::allocator<T>(other)
+    {}
+
+    template<typename U> void construct(U* pointer) noexcept(std::is_nothrow_default_constructible_v<U>) {
+        ::new (static_cast<void*>(pointer)) U;
+    }
+    template<typename U, typename... Args> void construct(U* pointer, Args&&... args) {
+        ::new (static_cast<void*>(pointer)) U(std::forward<Args>(args)...);
+    }
+};
\ No newline at end of file
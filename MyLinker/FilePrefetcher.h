@@ -0,0 +1,125 @@
+#pragma once
+#include "usingTypes.h"
+#include "BufferedBinaryFile.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+
+/*
+    Whole file loaded into memory by FilePrefetcher. bytes is null if the file couldn't be read.
+*/
+struct PrefetchedFile {
+    size_t index;
+    std::string name;
+    std::shared_ptr<std::vector<byte>> bytes;
+};
+
+/*
+    Loads files (in the given order) on a background I/O thread, ahead of their consumer, so reading
+    of the next files overlaps with processing of the current one.
+    Loaded files wait in a bounded queue: at most maxFilesInFlight files and maxBytesInFlight bytes
+    (a single file bigger than that is still loaded once the queue is empty).
+*/
+class FilePrefetcher {
+public:
+    FilePrefetcher(const FilePrefetcher& other)=delete;
+    FilePrefetcher(const std::vector<std::string>& fileNames, size_t maxFilesInFlight, size_t maxBytesInFlight) :
+        fileNames(fileNames),
+        maxFilesInFlight(std::max<size_t>(maxFilesInFlight, 1)),
+        maxBytesInFlight(maxBytesInFlight)
+    {
+        ioThread = std::thread([this]() { run(); });
+    }
+    virtual ~FilePrefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        spaceAvailable.notify_all();
+        if (ioThread.joinable()) {
+            ioThread.join();
+        }
+    }
+
+    FilePrefetcher operator=(const FilePrefetcher& other)=delete;
+
+    /*
+        Next loaded file (waits for it if needed). Returns nullopt after the last file.
+    */
+    std::optional<PrefetchedFile> next() {
+        std::unique_lock<std::mutex> lock(mutex);
+        fileAvailable.wait(lock, [this]() { return !queue.empty() || nextFileToLoad == fileNames.size(); });
+        if (queue.empty()) {
+            return std::nullopt;
+        }
+        auto file = std::move(queue.front());
+        queue.pop_front();
+        if (file.bytes) {
+            bytesInFlight -= file.bytes->size();
+        }
+        lock.unlock();
+        spaceAvailable.notify_all();
+        return file;
+    }
+
+private:
+    static std::shared_ptr<std::vector<byte>> loadFile(const std::string& fileName, size_t fileSize) {
+        auto bytes = std::make_shared<std::vector<byte>>(fileSize);
+        BufferedBinaryFile file(fileName);
+        if (!file || file.read(reinterpret_cast<char*>(bytes->data()), static_cast<int>(fileSize)) != static_cast<int>(fileSize)) {
+            return nullptr;
+        }
+        return bytes;
+    }
+
+    void run() {
+        for (size_t i = 0; i < fileNames.size(); ++i) {
+            std::error_code error;
+            size_t fileSize = static_cast<size_t>(std::filesystem::file_size(fileNames[i], error));
+            if (error) {
+                fileSize = 0;
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                spaceAvailable.wait(lock, [&]() {
+                    return stopping || queue.empty() || (queue.size() < maxFilesInFlight && bytesInFlight + fileSize <= maxBytesInFlight);
+                });
+                if (stopping) return;
+                bytesInFlight += fileSize;
+            }
+
+            auto bytes = error ? nullptr : loadFile(fileNames[i], fileSize);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!bytes) {
+                    bytesInFlight -= fileSize;
+                }
+                queue.push_back({i, fileNames[i], bytes});
+                nextFileToLoad = i + 1;
+            }
+            fileAvailable.notify_all();
+        }
+    }
+
+    const std::vector<std::string>& fileNames;
+    size_t maxFilesInFlight;
+    size_t maxBytesInFlight;
+
+    std::mutex mutex;
+    std::condition_variable spaceAvailable;
+    std::condition_variable fileAvailable;
+    std::deque<PrefetchedFile> queue;
+    size_t bytesInFlight = 0;
+    size_t nextFileToLoad = 0;
+    bool stopping = false;
+    std::thread ioThread;
+};
\ No newline at end of file
@@ -0,0 +1,170 @@
+#pragma once
+#include "usingTypes.h"
+#include "ByteSpan.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include "Windows.h"
+#else
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <cerrno>
+#endif
+
+/*
+    Output file written with vectored (gather) writes: many separate blocks of memory that end up
+    next to each other in the file are written with a single system call (pwritev).
+    Windows has no general gather write (WriteFileGather needs page sized and page aligned blocks),
+    so there large blocks are written by one WriteFile call each (one per GiB) and runs of small blocks
+    (headers, padding) are first copied into a scratch buffer of at most ScratchSize bytes.
+*/
+class GatherOutputFile {
+public:
+    GatherOutputFile(const GatherOutputFile& other)=delete;
+    GatherOutputFile(const std::string& filePath) {
+        open(filePath);
+    }
+    virtual ~GatherOutputFile() {
+        close();
+    }
+
+    GatherOutputFile operator=(const GatherOutputFile& other)=delete;
+
+    bool open(const std::string& newFilePath) {
+        close();
+        filePath = newFilePath;
+#ifdef _WIN32
+        file = CreateFileA(filePath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        return file != INVALID_HANDLE_VALUE;
+#else
+        file = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0755);
+        return file != -1;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (file != -1) ::close(file);
+        file = -1;
+#endif
+    }
+
+    /*
+        Writes all blocks one after another, starting at the given position in the file.
+    */
+    bool write(const std::vector<ByteSpan>& blocks, long long position) {
+        if (!*this) return false;
+#ifdef _WIN32
+        std::vector<byte> scratch;
+        long long scratchPosition = position;
+        auto flushScratch = [&]() {
+            bool written = writeAt(scratch.data(), scratch.size(), scratchPosition);
+            scratch.clear();
+            return written;
+        };
+        for (auto& block : blocks) {
+            if (block.size() < ScratchSize) {
+                if (scratch.size() + block.size() > ScratchSize && !flushScratch()) return false;
+                if (scratch.empty()) {
+                    scratch.reserve(ScratchSize);
+                    scratchPosition = position;
+                }
+                scratch.insert(scratch.end(), block.begin(), block.end());
+            } else {
+                if (!flushScratch() || !writeAt(block.data(), block.size(), position)) return false;
+            }
+            position += block.size();
+        }
+        return flushScratch();
+#else
+        std::vector<iovec> vectors;
+        vectors.reserve(blocks.size());
+        for (auto& block : blocks) {
+            if (!block.empty()) {
+                vectors.push_back({const_cast<byte*>(block.data()), block.size()});
+            }
+        }
+
+        size_t first = 0;
+        while (first < vectors.size()) {
+            int count = static_cast<int>(std::min<size_t>(vectors.size() - first, IOV_MAX));
+            systemCallCount += 1;
+            ssize_t written = pwritev(file, &vectors[first], count, position);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (written == 0) return false;
+            position += written;
+
+            // skip fully written blocks and continue after partial write
+            while (first < vectors.size() && static_cast<size_t>(written) >= vectors[first].iov_len) {
+                written -= vectors[first].iov_len;
+                first += 1;
+            }
+            if (written > 0) {
+                vectors[first].iov_base = static_cast<byte*>(vectors[first].iov_base) + written;
+                vectors[first].iov_len -= written;
+            }
+        }
+        return true;
+#endif
+    }
+
+    /*
+        Number of write system calls made so far.
+    */
+    int getSystemCallCount() const {
+        return systemCallCount;
+    }
+
+    operator bool() const {
+#ifdef _WIN32
+        return file != INVALID_HANDLE_VALUE;
+#else
+        return file != -1;
+#endif
+    }
+
+    std::string getFilePath() {
+        return filePath;
+    }
+
+private:
+#ifdef _WIN32
+    static constexpr size_t ScratchSize = 64 * 1024;
+
+    bool writeAt(const byte* data, size_t size, long long position) {
+        while (size > 0) {
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = static_cast<DWORD>(position);
+            overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+            DWORD toWrite = static_cast<DWORD>(std::min<size_t>(size, 1 << 30));
+            DWORD written = 0;
+            systemCallCount += 1;
+            if (!WriteFile(file, data, toWrite, &written, &overlapped) || written == 0) return false;
+            data += written;
+            size -= written;
+            position += written;
+        }
+        return true;
+    }
+
+    HANDLE file = INVALID_HANDLE_VALUE;
+#else
+    int file = -1;
+#endif
+    std::string filePath = "";
+    int systemCallCount = 0;
+};
\ No newline at end of file
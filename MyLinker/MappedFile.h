@@ -0,0 +1,192 @@
+#pragma once
+#include "usingTypes.h"
+#include "ByteSpan.h"
+
+#include <string>
+#include <optional>
+#include <cstring>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include "Windows.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+    Read-only reader that maps the whole file into memory once.
+    Provides the same reading interface as BinaryFile and BufferedBinaryFile,
+    but every read is a plain memcpy from the mapped view (no system call per field).
+    Nothing is read ahead for the whole file - only parts that are actually going to be read
+    are hinted to the system (willNeed), so parts that are never read aren't paged in.
+    The file itself is closed as soon as it's mapped (the mapping stays valid), so mapped files
+    don't count against the limit of opened files.
+*/
+class MappedFile {
+public:
+    MappedFile(const MappedFile& other)=delete;
+    MappedFile(const std::string& filePath, bool createFile=false) {
+        open(filePath, createFile);
+    }
+    virtual ~MappedFile() {
+        close();
+    }
+
+    MappedFile operator=(const MappedFile& other)=delete;
+
+    void close() {
+#ifdef _WIN32
+        if (view) UnmapViewOfFile(view);
+#else
+        if (view) munmap(const_cast<byte*>(view), fileSize);
+#endif
+        view = nullptr;
+        fileSize = 0;
+        position = 0;
+        isOpen = false;
+    }
+
+    // only reading of existing files is supported (createFile=true always fails)
+    bool open(const std::string& newFilePath, bool createFile=false) {
+        close();
+        filePath = newFilePath;
+        clearFail();
+        if (createFile) return false;
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        bool sized = GetFileSizeEx(file, &size);
+        fileSize = sized ? static_cast<size_t>(size.QuadPart) : 0;
+        if (sized && fileSize > 0) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                view = static_cast<const byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping); // the view keeps the mapping alive
+            }
+        }
+        CloseHandle(file);
+#else
+        int file = ::open(filePath.c_str(), O_RDONLY);
+        if (file == -1) return false;
+        struct stat fileStat;
+        bool sized = fstat(file, &fileStat) == 0;
+        fileSize = sized ? static_cast<size_t>(fileStat.st_size) : 0;
+        if (sized && fileSize > 0) {
+            void* mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, file, 0);
+            if (mapped != MAP_FAILED) view = static_cast<const byte*>(mapped);
+        }
+        ::close(file); // the mapping stays valid without the descriptor
+#endif
+        if (!sized || (fileSize > 0 && !view)) return false;
+
+        isOpen = true;
+        return true;
+    }
+
+    void clearFail() {
+        failFlag = false;
+    }
+
+    void setPosition(long newPosition) {
+        clearFail();
+        position = newPosition;
+    }
+    long getPosition() {
+        return static_cast<long>(position);
+    }
+
+    bool read(char* resultBuffer, int sizeInBytes) {
+        if (!*this) return false;
+        if (sizeInBytes < 0 || position > fileSize || static_cast<size_t>(sizeInBytes) > fileSize - position) {
+            failFlag = true;
+            return false;
+        }
+        memcpy(resultBuffer, view + position, sizeInBytes);
+        position += sizeInBytes;
+        return true;
+    }
+    template<typename T, int Size> bool read(T (&resultBuffer)[Size]) {
+        return read(reinterpret_cast<char*>(resultBuffer), Size * sizeof(T));
+    }
+    template<typename T> std::optional<T> read() {
+        T result;
+        if (read(reinterpret_cast<char*>(&result), sizeof(T))) {
+            return result;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    /*
+        Returns a view of the next sizeInBytes bytes without copying them.
+        The view stays valid as long as this file is open.
+    */
+    std::optional<ByteSpan> readView(int sizeInBytes) {
+        if (!*this) return std::nullopt;
+        if (sizeInBytes < 0 || position > fileSize || static_cast<size_t>(sizeInBytes) > fileSize - position) {
+            failFlag = true;
+            return std::nullopt;
+        }
+        ByteSpan result(view + position, sizeInBytes);
+        position += sizeInBytes;
+        return result;
+    }
+
+    /*
+        Whole contents of the file (valid as long as this file is open).
+    */
+    ByteSpan contents() const {
+        return ByteSpan(view, fileSize);
+    }
+
+    /*
+        Hints the system that the given part of a mapped file is going to be read soon,
+        so it gets paged in ahead (in one go, instead of page by page as it's touched).
+    */
+    static void willNeed(ByteSpan range) {
+        if (range.empty()) return;
+#ifdef _WIN32
+        WIN32_MEMORY_RANGE_ENTRY entry = {const_cast<byte*>(range.data()), range.size()};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+#else
+        static const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        uintptr_t begin = reinterpret_cast<uintptr_t>(range.data()) & ~(pageSize - 1);
+        uintptr_t end = reinterpret_cast<uintptr_t>(range.data()) + range.size();
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+#endif
+    }
+
+    template<typename T> MappedFile& operator>>(T& value) {
+        auto readResult = read<T>();
+        if (readResult) value = *readResult;
+        return *this;
+    }
+    template<typename T, int Size> MappedFile& operator>>(T (&array)[Size]) {
+        read(array);
+        return *this;
+    }
+
+    operator bool() {
+        return isOpen && !failFlag;
+    }
+
+    std::string getFilePath() {
+        return filePath;
+    }
+
+private:
+    std::string filePath = "";
+    const byte* view = nullptr;
+    size_t fileSize = 0;
+    size_t position = 0;
+    bool isOpen = false;
+    bool failFlag = false;
+};
\ No newline at end of file
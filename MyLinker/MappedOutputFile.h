@@ -0,0 +1,100 @@
+#pragma once
+#include "usingTypes.h"
+
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include "Windows.h"
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+    Output file of fixed size created (or truncated) and mapped for writing as a whole.
+    Contents can be produced directly in the mapping, including from multiple threads at once.
+*/
+class MappedOutputFile {
+public:
+    MappedOutputFile(const MappedOutputFile& other)=delete;
+    MappedOutputFile(const std::string& filePath, size_t fileSize) {
+        open(filePath, fileSize);
+    }
+    virtual ~MappedOutputFile() {
+        close();
+    }
+
+    MappedOutputFile operator=(const MappedOutputFile& other)=delete;
+
+    bool open(const std::string& newFilePath, size_t newFileSize) {
+        close();
+        filePath = newFilePath;
+        if (newFileSize == 0) return false;
+
+#ifdef _WIN32
+        file = CreateFileA(filePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        // mapping of size bigger than the file extends the file
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(qword(newFileSize) >> 32), static_cast<DWORD>(newFileSize), nullptr);
+        if (!mapping) return false;
+        view = static_cast<byte*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, newFileSize));
+        if (!view) return false;
+#else
+        file = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0755);
+        if (file == -1) return false;
+        if (ftruncate(file, static_cast<off_t>(newFileSize)) != 0) return false;
+        void* mapped = mmap(nullptr, newFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (mapped == MAP_FAILED) return false;
+        view = static_cast<byte*>(mapped);
+#endif
+
+        fileSize = newFileSize;
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (view) UnmapViewOfFile(view);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (view) munmap(view, fileSize);
+        if (file != -1) ::close(file);
+        file = -1;
+#endif
+        view = nullptr;
+        fileSize = 0;
+    }
+
+    byte* data() {
+        return view;
+    }
+    size_t size() const {
+        return fileSize;
+    }
+
+    operator bool() const {
+        return view != nullptr;
+    }
+
+    std::string getFilePath() {
+        return filePath;
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int file = -1;
+#endif
+    std::string filePath = "";
+    byte* view = nullptr;
+    size_t fileSize = 0;
+};
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+#include "usingTypes.h"
+
+#include <cstring>
+
+/*
+    Writer with the same writing interface as BinaryFile, but writing into a fixed block of memory.
+    Writing past the end of the block fails (and nothing gets written).
+*/
+class MemoryWriter {
+public:
+    MemoryWriter(byte* memory, size_t memorySize) :
+        memory(memory),
+        memorySize(memorySize)
+    {}
+
+    void setPosition(long newPosition) {
+        position = newPosition;
+    }
+    long getPosition() {
+        return static_cast<long>(position);
+    }
+
+    bool write(const char* bytes, const int sizeInBytes) {
+        if (sizeInBytes < 0 || position > memorySize || static_cast<size_t>(sizeInBytes) > memorySize - position) {
+            failFlag = true;
+            return false;
+        }
+        memcpy(memory + position, bytes, sizeInBytes);
+        position += sizeInBytes;
+        return true;
+    }
+
+    template<typename T> bool write(const T t) {
+        return write(reinterpret_cast<const char*>(&t), sizeof(T));
+    }
+    template<typename T, int Size> bool write(const T (&t)[Size]) {
+        return write(reinterpret_cast<const char*>(t), sizeof(T)*Size);
+    }
+
+    template<typename T> MemoryWriter& operator<<(const T c) {
+        write(c);
+        return *this;
+    }
+    template<typename T, int Size> MemoryWriter& operator<<(const T (&c)[Size]) {
+        write(c);
+        return *this;
+    }
+
+    operator bool() {
+        return !failFlag;
+    }
+
+private:
+    byte* memory;
+    size_t memorySize;
+    size_t position = 0;
+    bool failFlag = false;
+};
\ No newline at end of file
@@ -4,12 +4,24 @@
 #include "SectionHeader.h"
 #include "SymbolTableEntry.h"
 #include "errorMessages.h"
+#include "ByteSpan.h"
+#include "StringTable.h"
+#include "SymbolInterner.h"
+#include "PositionalFile.h"
 
 #include <vector>
 #include <optional>
-#include <map>
+#include <utility>
+#include <cctype>
+#include <algorithm>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <type_traits>
 #include <iomanip>
 #include <iostream>
+#include <filesystem>
+#include <limits>
 
 struct RelocationEntry {
     enum TypeIntel386 {
@@ -22,6 +34,20 @@ struct RelocationEntry {
         Secrel7  = 0xd, // A 7-bit offset from the base of the section that contains the target. 
         Rel32    = 0x14 // The 32-bit relative displacement to the target. This supports the x86 relative branch and call instructions. 
     };
+    enum TypeAmd64 {
+        Amd64Absolute = 0x0, // The relocation is ignored. 
+        Addr64        = 0x1, // The 64-bit VA of the relocation target. 
+        Addr32        = 0x2, // The 32-bit VA of the relocation target. 
+        Addr32nb      = 0x3, // The 32-bit address without an image base (RVA). 
+        Amd64Rel32    = 0x4, // The 32-bit relative address from the byte following the relocation. 
+        Rel32_1       = 0x5, // The 32-bit address relative to byte distance 1 from the relocation. 
+        Rel32_2       = 0x6, // The 32-bit address relative to byte distance 2 from the relocation. 
+        Rel32_3       = 0x7, // The 32-bit address relative to byte distance 3 from the relocation. 
+        Rel32_4       = 0x8, // The 32-bit address relative to byte distance 4 from the relocation. 
+        Rel32_5       = 0x9, // The 32-bit address relative to byte distance 5 from the relocation. 
+        Amd64Section  = 0xa, // The 16-bit section index of the section that contains the target. This is used to support debugging information. 
+        Amd64Secrel   = 0xb, // The 32-bit offset of the target from the beginning of its section. This is used to support debugging information and static thread local storage. 
+    };
 
     /*
         The address of the item to which relocation is applied. 
@@ -39,33 +65,276 @@ struct RelocationEntry {
         A value that indicates the kind of relocation that should be performed. Valid relocation types depend on machine type. 
     */
     word type;
-};
-
-template<typename Reader> std::optional<RelocationEntry> readRelocationEntry(Reader& reader) {
-    RelocationEntry relocationEntry;
 
-    reader >> relocationEntry.virtualAddress;
-    reader >> relocationEntry.symbolTableIndex;
-    reader >> relocationEntry.type;
+    static int Size() {
+        return 10;
+    }
+};
 
-    return reader ? relocationEntry : std::optional<RelocationEntry>(std::nullopt);
+/*
+    Decodes a whole relocation table that was read into memory in one go.
+*/
+void decodeRelocationEntries(ByteSpan data, std::vector<RelocationEntry>& relocationTable) {
+    size_t count = data.size() / RelocationEntry::Size();
+    relocationTable.resize(count);
+    const byte* record = data.data();
+    for (size_t i = 0; i < count; ++i, record += RelocationEntry::Size()) {
+        relocationTable[i].virtualAddress   = loadValue<dword>(record);
+        relocationTable[i].symbolTableIndex = loadValue<dword>(record + 4);
+        relocationTable[i].type             = loadValue<word>(record + 8);
+    }
 }
 
+/*
+    Section data isn't kept in ObjectSection - it's read (with readSectionData) only when and where it's needed.
+    Relocations are read on demand too (with loadRelocations).
+*/
 struct ObjectSection {
     SectionHeader header;
-    std::vector<byte> data;
     std::vector<RelocationEntry> relocationTable;
+    bool relocationsLoaded = false;
+    bool discarded = false; // never becomes part of the image (see isDiscardedSection), so its contents are never read
 };
 
+/*
+    Sections marked as LinkRemove (like .drectve) and debug information sections (.debug$S, .debug$T, ...)
+    don't become part of the image.
+*/
+bool isDiscardedSection(const SectionHeader& header) {
+    static constexpr char DebugPrefix[] = ".debug$";
+    return (header.characteristics & SectionHeader::Characteristic::LinkRemove)
+        || std::equal(std::begin(DebugPrefix), std::end(DebugPrefix) - 1, header.name.begin());
+}
+
+/*
+    Name of a symbol (short names are stored inline, long ones are offsets into the string table).
+*/
+std::optional<std::string_view> getSymbolName(const std::array<byte, 8>& arr, const StringTable& stringTable) {
+    if (arr[0] == 0 && arr[1] == 0 && arr[2] == 0 && arr[3] == 0) {
+        return stringTable.at(loadValue<dword>(&arr[4]));
+    } else {
+        auto* name = reinterpret_cast<const char*>(arr.data());
+        return std::string_view(name, std::find(name, name + arr.size(), '\0') - name);
+    }
+}
+
+/*
+    Name of a section (names longer than 8 characters are stored as "/" followed by the decimal
+    offset of the name in the string table).
+*/
+std::optional<std::string_view> getSectionName(const SectionHeader& header, const StringTable& stringTable) {
+    auto* name = reinterpret_cast<const char*>(header.name.data());
+    std::string_view shortName(name, std::find(name, name + header.name.size(), '\0') - name);
+    if (shortName.empty() || shortName[0] != '/') {
+        return shortName;
+    }
+    dword offset = 0;
+    for (size_t i = 1; i < shortName.size(); ++i) {
+        if (!isdigit(static_cast<unsigned char>(shortName[i]))) {
+            return std::nullopt;
+        }
+        offset = offset * 10 + (shortName[i] - '0');
+    }
+    return stringTable.at(offset);
+}
+
+/*
+    Splits a grouped section name ("name$suffix") into the name of the section it's merged into and the
+    suffix that orders it there. Names without '$' have an empty suffix, so they come first.
+*/
+std::pair<std::string_view, std::string_view> splitGroupedSectionName(std::string_view sectionName) {
+    auto dollar = sectionName.find('$');
+    if (dollar == std::string_view::npos) {
+        return {sectionName, std::string_view()};
+    }
+    return {sectionName.substr(0, dollar), sectionName.substr(dollar + 1)};
+}
+
 struct ObjectFile {
     FileHeader fileHeader;
     std::vector<ObjectSection> sections;
-    std::vector<SymbolTableEntry> symbolTableEntries;
-    std::map<int, std::string> stringTable;
+    SymbolTable symbolTable;
+    StringTable stringTable;
+    std::vector<SymbolId> symbolNameIds; // interned names of external symbols (InvalidSymbolId for other rows), indexed like symbolTable
+    std::vector<std::shared_ptr<const void>> storage; // owners of the memory that views (string table, file contents) point into
+
+    /*
+        Reads size bytes of the file starting at position into destination. Set by readObjectFile.
+        Can be called from multiple threads at once.
+    */
+    std::function<bool(size_t position, size_t size, byte* destination)> readContents;
 };
 
-template <typename Reader> std::optional<ObjectFile> readObjectFile(const std::string& objFileName) {
-    Reader inFile(objFileName, false);
+/*
+    Calls function(symbolIndex, sectionIndex) for every external symbol that the object file defines in
+    one of its sections (sectionIndex is 0-based). Symbols in discarded sections are skipped.
+    Only storage class and section number columns are scanned for most symbols.
+*/
+template<typename Function> void forEachDefinedExternal(const ObjectFile& objFile, Function function) {
+    auto& symbols = objFile.symbolTable;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (symbols.storageClass(i) != StandardSymbol::StorageClass::External || symbols.isAuxiliary(i)) {
+            continue;
+        }
+        word sectionNumber = symbols.sectionNumber(i);
+        if (sectionNumber > 0 && sectionNumber <= objFile.sections.size() && !objFile.sections[sectionNumber-1].discarded) {
+            function(i, static_cast<size_t>(sectionNumber - 1));
+        }
+    }
+}
+
+/*
+    Bytes of section contents (data and relocations) in all read object files, and how many of them were actually read.
+*/
+struct SectionContentsStats {
+    static inline std::atomic<size_t> totalBytes = 0;
+    static inline std::atomic<size_t> readBytes = 0;
+};
+
+/*
+    Reads data of the section into destination (nothing for uninitialized data sections).
+*/
+bool readSectionData(const ObjectFile& objFile, const ObjectSection& section, byte* destination) {
+    if (section.header.sizeOfRawData == 0 || (section.header.characteristics & SectionHeader::Characteristic::ContainsUninitializedData)) {
+        return true;
+    }
+    SectionContentsStats::readBytes += section.header.sizeOfRawData;
+    return objFile.readContents && objFile.readContents(section.header.pointerToRawData, section.header.sizeOfRawData, destination);
+}
+
+/*
+    Reads relocations of the section (if they weren't read before).
+*/
+bool loadRelocations(const ObjectFile& objFile, ObjectSection& section) {
+    if (section.relocationsLoaded) {
+        return true;
+    }
+    if (section.header.numberOfRelocations > 0) {
+        size_t size = section.header.numberOfRelocations * RelocationEntry::Size();
+        std::vector<byte> relocationsData(size);
+        SectionContentsStats::readBytes += size;
+        if (!objFile.readContents || !objFile.readContents(section.header.pointerToRelocations, size, relocationsData.data())) {
+            return false;
+        }
+        decodeRelocationEntries(ByteSpan(relocationsData.data(), size), section.relocationTable);
+    }
+    section.relocationsLoaded = true;
+    return true;
+}
+
+/*
+    Makes later reads of objFile's contents go to the file itself. Reads are positional (so they can come from
+    all threads at once) and go through PositionalFilePool::global(), which opens the file when it's needed
+    and keeps only a bounded number of files open for all object files.
+*/
+void readContentsFromFile(ObjectFile& objFile, const std::string& objFileName) {
+    objFile.readContents = [objFileName](size_t position, size_t size, byte* destination) {
+        return PositionalFilePool::global().read(objFileName, position, size, destination);
+    };
+}
+
+/*
+    Makes objFile independent of the memory it was read from (like a whole file loaded by FilePrefetcher), so that
+    memory can be released right after parsing: the string table is copied into memory owned by objFile and
+    section contents are read from the file itself when they're needed.
+*/
+void detachFromReadMemory(ObjectFile& objFile, const std::string& objFileName) {
+    auto strings = objFile.stringTable.contents();
+    auto ownedStrings = std::make_shared<std::vector<byte>>(strings.begin(), strings.end());
+    objFile.stringTable = StringTable(ByteSpan(ownedStrings->data(), ownedStrings->size()));
+    objFile.storage.clear();
+    objFile.storage.emplace_back(ownedStrings);
+    readContentsFromFile(objFile, objFileName);
+}
+
+/*
+    Readers that can hand out views of their contents (like MappedFile) let sections and the string table
+    reference the input directly. With other readers these get read into buffers owned by ObjectFile.
+*/
+template<typename Reader, typename = void> struct ReaderHasViews : std::false_type {};
+template<typename Reader> struct ReaderHasViews<Reader, std::void_t<decltype(std::declval<Reader&>().readView(0))>> : std::true_type {};
+
+/*
+    Readers with views whose memory is paged in on demand (like MappedFile) are told which parts of it
+    are going to be read (Reader::willNeed), everything else is never touched.
+*/
+template<typename Reader, typename = void> struct ReaderHasHints : std::false_type {};
+template<typename Reader> struct ReaderHasHints<Reader, std::void_t<decltype(Reader::willNeed(std::declval<ByteSpan>()))>> : std::true_type {};
+
+/*
+    Hints that size bytes of the reader's contents starting at position are going to be read
+    (does nothing for other readers and for ranges outside of the contents).
+*/
+template<typename Reader> void readerWillNeed(const Reader& reader, size_t position, size_t size) {
+    if constexpr (ReaderHasHints<Reader>::value) {
+        auto contents = reader.contents();
+        if (position < contents.size()) {
+            Reader::willNeed(contents.subspan(position, std::min(size, contents.size() - position)));
+        }
+    }
+}
+
+/*
+    Size of the file that reader reads (0 if it can't be found out).
+*/
+template<typename Reader> size_t readerFileSize(const Reader& reader, const std::string& fileName) {
+    if constexpr (ReaderHasViews<Reader>::value) {
+        return reader.contents().size();
+    } else {
+        std::error_code error;
+        auto size = std::filesystem::file_size(fileName, error);
+        return error ? 0 : static_cast<size_t>(size);
+    }
+}
+
+/*
+    Checks that size bytes starting at position are inside of a file of fileSize bytes
+    (and that they can be read by a single readBlock).
+*/
+bool isInFile(size_t position, size_t size, size_t fileSize) {
+    return position <= fileSize && size <= fileSize - position && size <= static_cast<size_t>(std::numeric_limits<int>::max());
+}
+
+/*
+    Reads sizeInBytes bytes from the current position with a single read operation.
+    Readers with views don't copy at all, other readers fill (and reuse) the given buffer.
+*/
+template<typename Reader> std::optional<ByteSpan> readBlock(Reader& reader, int sizeInBytes, std::vector<byte>& buffer) {
+    if constexpr (ReaderHasViews<Reader>::value) {
+        return reader.readView(sizeInBytes);
+    } else {
+        buffer.resize(sizeInBytes);
+        reader.read(reinterpret_cast<char*>(buffer.data()), sizeInBytes);
+        if (!reader) return std::nullopt;
+        return ByteSpan(buffer.data(), buffer.size());
+    }
+}
+
+/*
+    Like readBlock, but the returned view stays valid as long as objFile does
+    (read buffers are kept alive by objFile.storage).
+*/
+template<typename Reader> std::optional<ByteSpan> readPersistentBlock(Reader& reader, int sizeInBytes, ObjectFile& objFile) {
+    if constexpr (ReaderHasViews<Reader>::value) {
+        return reader.readView(sizeInBytes);
+    } else {
+        auto buffer = std::make_shared<std::vector<byte>>(sizeInBytes);
+        reader.read(reinterpret_cast<char*>(buffer->data()), sizeInBytes);
+        if (!reader) return std::nullopt;
+        objFile.storage.emplace_back(buffer);
+        return ByteSpan(buffer->data(), buffer->size());
+    }
+}
+
+/*
+    Reads an object file from an already opened reader (e.g. SpanReader over bytes in memory).
+    Only headers, symbols and strings are read here - section data and relocations are read later,
+    only for sections that need them (see readSectionData and loadRelocations).
+    With readers that have views, the string table and later reads point into/copy from the reader's memory,
+    which has to outlive the returned ObjectFile. With other readers, later reads open the file (objFileName)
+    again (see readContentsFromFile).
+*/
+template <typename Reader> std::optional<ObjectFile> readObjectFile(Reader& inFile, const std::string& objFileName) {
     if (!inFile) return std::nullopt;
 
     ObjectFile objFile;
@@ -76,55 +345,71 @@ template <typename Reader> std::optional<ObjectFile> readObjectFile(const std::s
     objFile.fileHeader = *fileHeader;
 
     // read section headers
+    readerWillNeed(inFile, inFile.getPosition(), objFile.fileHeader.numberOfSections * SectionHeader::Size());
     objFile.sections.resize(objFile.fileHeader.numberOfSections);
     for (auto& section : objFile.sections) {
         auto sectionHeader = readSectionHeader(inFile);
         if (!sectionHeader) return errorMessageOpt("Couldn't read section header in obj file '" + objFileName + "'");
         section.header = *sectionHeader;
+        section.discarded = isDiscardedSection(section.header);
+        if (!(section.header.characteristics & SectionHeader::Characteristic::ContainsUninitializedData)) {
+            SectionContentsStats::totalBytes += section.header.sizeOfRawData;
+        }
+        SectionContentsStats::totalBytes += section.header.numberOfRelocations * RelocationEntry::Size();
     }
 
-    // read sections data
-    for (auto& section : objFile.sections) {
-        inFile.setPosition(section.header.pointerToRawData);
-        section.data.resize(section.header.sizeOfRawData);
-        inFile.read(reinterpret_cast<char*>(section.data.data()), static_cast<int>(section.data.size()));
-
-        if (section.header.numberOfRelocations > 0) {
-            inFile.setPosition(section.header.pointerToRelocations);
-            section.relocationTable.resize(section.header.numberOfRelocations);
-            for (auto& relocationEntry : section.relocationTable) {
-                auto relocation = readRelocationEntry(inFile);
-                if (!relocation) return errorMessageOpt("Couldn't read relocation entry in obj file '" + objFileName + "'");
-                relocationEntry = *relocation;
+    // section contents are read later
+    if constexpr (ReaderHasViews<Reader>::value) {
+        objFile.readContents = [contents = inFile.contents()](size_t position, size_t size, byte* destination) {
+            if (position > contents.size() || size > contents.size() - position) {
+                return false;
             }
-        }
+            if constexpr (ReaderHasHints<Reader>::value) {
+                Reader::willNeed(contents.subspan(position, size));
+            }
+            memcpy(destination, contents.data() + position, size);
+            return true;
+        };
+    } else {
+        readContentsFromFile(objFile, objFileName);
     }
 
-    // read symbol table entries
+    // read symbol table entries (whole table at once, then decoded in memory). sizes are checked against
+    // the file first, so malformed headers can't make the buffers absurdly big
+    size_t fileSize = readerFileSize(inFile, objFileName);
+    size_t symbolTableSize = static_cast<size_t>(objFile.fileHeader.numberOfSymbols) * StandardSymbol::Size();
+    if (!isInFile(objFile.fileHeader.pointerToSymbolTable, symbolTableSize, fileSize)) {
+        return errorMessageOpt("Couldn't read symbol table entry in obj file '" + objFileName + "'");
+    }
     inFile.setPosition(objFile.fileHeader.pointerToSymbolTable);
-    objFile.symbolTableEntries.reserve(objFile.fileHeader.numberOfSymbols);
-    for (int i = 0; i < static_cast<int>(objFile.fileHeader.numberOfSymbols); ++i) {
-        if (!readSymbolTableEntry(inFile, objFile.symbolTableEntries, i)) {
-            return errorMessageOpt("Couldn't read symbol table entry in obj file '" + objFileName + "'");
-        }
+    readerWillNeed(inFile, objFile.fileHeader.pointerToSymbolTable, fileSize - objFile.fileHeader.pointerToSymbolTable); // symbol and string table
+    std::vector<byte> symbolTableBuffer;
+    auto symbolTableData = readBlock(inFile, static_cast<int>(symbolTableSize), symbolTableBuffer);
+    if (!symbolTableData || !decodeSymbolTable(*symbolTableData, objFile.symbolTable)) {
+        return errorMessageOpt("Couldn't read symbol table entry in obj file '" + objFileName + "'");
     }
 
-    // read string table
+    // read string table (its size includes the size field itself). Missing string table is treated as empty
     dword stringTableSize = 0;
     inFile >> stringTableSize;
-
-    int stringByteIndex = 4;
-    while (inFile) {
-        byte b = 0;
-        std::string stringEntry = "";
-        while (true) {
-            inFile >> b;
-            if (b == 0) break;
-            stringEntry += b;
+    if (inFile && stringTableSize > StringTable::SizeFieldSize) {
+        size_t stringsSize = stringTableSize - StringTable::SizeFieldSize;
+        if (!isInFile(static_cast<size_t>(inFile.getPosition()), stringsSize, fileSize)) {
+            return errorMessageOpt("Couldn't read string table in obj file '" + objFileName + "'");
         }
-        if (!stringEntry.empty()) {
-            objFile.stringTable.emplace(stringByteIndex, stringEntry);
-            stringByteIndex += stringEntry.size() + 1;
+        auto stringTableData = readPersistentBlock(inFile, static_cast<int>(stringsSize), objFile);
+        if (!stringTableData) return errorMessageOpt("Couldn't read string table in obj file '" + objFileName + "'");
+        objFile.stringTable = StringTable(*stringTableData);
+    }
+
+    // intern names of external symbols - these are the ones resolved across object files
+    auto& symbols = objFile.symbolTable;
+    objFile.symbolNameIds.assign(symbols.size(), InvalidSymbolId);
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (!symbols.isAuxiliary(i) && symbols.storageClass(i) == StandardSymbol::StorageClass::External) {
+            auto symbolName = getSymbolName(symbols.name(i), objFile.stringTable);
+            if (!symbolName) return errorMessageOpt("Couldn't read symbol name in obj file '" + objFileName + "'");
+            objFile.symbolNameIds[i] = SymbolInterner::global().intern(*symbolName);
         }
     }
 
@@ -132,6 +417,18 @@ template <typename Reader> std::optional<ObjectFile> readObjectFile(const std::s
 }
 
 
+/*
+    Reads the object file with the given name. Readers with views are kept alive by the returned ObjectFile.
+*/
+template <typename Reader> std::optional<ObjectFile> readObjectFile(const std::string& objFileName) {
+    auto reader = std::make_shared<Reader>(objFileName, false);
+    auto objFile = readObjectFile(*reader, objFileName);
+    if (objFile && ReaderHasViews<Reader>::value) {
+        objFile->storage.emplace_back(reader);
+    }
+    return objFile;
+}
+
 void dump(const ObjectFile& objFile) {
     std::cout << std::hex;
     std::cout << "machine              : " << objFile.fileHeader.machine << '\n';
@@ -159,12 +456,19 @@ void dump(const ObjectFile& objFile) {
         std::cout << "    characteristics      : " << section.header.characteristics << '\n';
         std::cout << "  " << "data: \n";
         std::cout << "    ";
-        for (auto b : section.data) {
+        std::vector<byte> data;
+        if (!(section.header.characteristics & SectionHeader::Characteristic::ContainsUninitializedData)) {
+            data.resize(section.header.sizeOfRawData);
+            readSectionData(objFile, section, data.data());
+        }
+        for (auto b : data) {
             std::cout << (int)b << ' ';
         }
         std::cout << '\n';
         std::cout << "  " << "relocation table: \n";
-        for (auto& relocationEntry : section.relocationTable) {
+        auto sectionWithRelocations = section;
+        loadRelocations(objFile, sectionWithRelocations);
+        for (auto& relocationEntry : sectionWithRelocations.relocationTable) {
             std::cout << "    entry: \n";
             std::cout << "      virtualAddress   : " << relocationEntry.virtualAddress << '\n';
             std::cout << "      symbolTableIndex : " << relocationEntry.symbolTableIndex << '\n';
@@ -174,10 +478,9 @@ void dump(const ObjectFile& objFile) {
 
     std::cout << '\n';
 
-    for (size_t i = 0; i < objFile.symbolTableEntries.size(); ++i) {
-        auto& symbolTableEntry = objFile.symbolTableEntries[i];
-        if (std::holds_alternative<StandardSymbol>(symbolTableEntry)) {
-            auto symbol = std::get<StandardSymbol>(symbolTableEntry);
+    for (size_t i = 0; i < objFile.symbolTable.size(); ++i) {
+        if (!objFile.symbolTable.isAuxiliary(i)) {
+            auto symbol = objFile.symbolTable.standardSymbol(i);
             std::cout << "standard symbol '";
             for (byte b : symbol.name) std::cout << b;
             std::cout << "':\n";
@@ -186,8 +489,8 @@ void dump(const ObjectFile& objFile) {
             std::cout << "type               : " << (int)symbol.type << '\n';
             std::cout << "storageClass       : " << (int)symbol.storageClass << '\n';
             std::cout << "numberOfAuxSymbols : " << (int)symbol.numberOfAuxSymbols << '\n';
-        } else {
-            auto symbol = std::get<AuxiliarySymbol>(symbolTableEntry);
+        } else if (auto auxiliarySymbol = objFile.symbolTable.auxiliarySymbol(i)) {
+            auto& symbol = *auxiliarySymbol;
             std::cout << "Auxiliary Symbol: \n";
             if (std::holds_alternative<AuxiliarySymbolFunctionDefinition>(symbol)) {
                 auto& functionDefinition = std::get<AuxiliarySymbolFunctionDefinition>(symbol);
@@ -221,8 +524,13 @@ void dump(const ObjectFile& objFile) {
 
     std::cout << "String table:\n";
     std::cout << std::left;
-    for (auto& stringEntry : objFile.stringTable) {
-        std::cout << std::setw(5) << stringEntry.first << stringEntry.second << '\n';
+    dword stringOffset = StringTable::SizeFieldSize;
+    while (stringOffset < objFile.stringTable.size()) {
+        auto stringEntry = *objFile.stringTable.at(stringOffset);
+        if (!stringEntry.empty()) {
+            std::cout << std::setw(5) << stringOffset << stringEntry << '\n';
+        }
+        stringOffset += static_cast<dword>(stringEntry.size()) + 1;
     }
     std::cout << '\n';
 }
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+/*
+    Calls function(i) for every i in [0, count) on up to threadCount threads (the calling thread included).
+    Indices are handed out one by one, so work items of uneven size still balance out.
+*/
+template<typename Function> void parallelFor(size_t count, int threadCount, Function function) {
+    size_t workerCount = std::min<size_t>(std::max(threadCount, 1), count);
+    if (workerCount <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            function(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> nextIndex = 0;
+    auto worker = [&]() {
+        for (size_t i = nextIndex++; i < count; i = nextIndex++) {
+            function(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workerCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/*
+    Number of threads to use when the user didn't choose.
+*/
+int defaultThreadCount() {
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
\ No newline at end of file
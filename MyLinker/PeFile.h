@@ -4,18 +4,30 @@
 #include "PeHeader.h"
 #include "SectionHeader.h"
 #include "ImportDirectory.h"
+#include "MappedOutputFile.h"
+#include "GatherOutputFile.h"
+#include "MemoryWriter.h"
+#include "ParallelFor.h"
+#include "DefaultInitAllocator.h"
 
 #include <vector>
 #include <optional>
 #include <algorithm>
 #include <string_view>
 #include <filesystem>
+#include <atomic>
+#include <cstring>
 
 namespace fs = std::filesystem;
 
+/*
+    Bytes of a section. Resizing doesn't zero the new bytes (they're filled right after that).
+*/
+using SectionData = std::vector<byte, DefaultInitAllocator<byte>>;
+
 struct PeSection {
     SectionHeader header;
-    std::vector<byte> data;
+    SectionData data;
 };
 
 struct PeFile {
@@ -24,6 +36,14 @@ struct PeFile {
     std::vector<PeSection> sections;
 };
 
+template<typename Writer> void writeHeaders(Writer& out, const PeFile& peFile) {
+    write(out, peFile.dosHeader);
+    write(out, peFile.peHeader);
+    for (auto& imageSection : peFile.sections) {
+        write(out, imageSection.header);
+    }
+}
+
 template<typename Writer> bool write(Writer& out, const PeFile& peFile, std::string_view filePath) {
     // set appropriate file size and fill it with zeros
     out.setPosition(0);
@@ -35,11 +55,7 @@ template<typename Writer> bool write(Writer& out, const PeFile& peFile, std::str
 
     // write headers at the start of the file
     out.setPosition(0);
-    write(out, peFile.dosHeader);
-    write(out, peFile.peHeader);
-    for (auto& imageSection : peFile.sections) {
-        write(out, imageSection.header);
-    }
+    writeHeaders(out, peFile);
 
     // write sections contents
     for (auto& imageSection : peFile.sections) {
@@ -48,4 +64,122 @@ template<typename Writer> bool write(Writer& out, const PeFile& peFile, std::str
     }
 
     return bool(out);
+}
+
+/*
+    Writes the PE file through a memory mapping of the whole output file. Headers are serialized straight
+    into the mapping and every section with data in the file is produced by fillSection(sectionNr, destination)
+    directly at its final location (destination is zero filled), on up to threadCount threads at once.
+*/
+template<typename FillSection> bool writeMapped(const PeFile& peFile, const std::string& filePath, int threadCount, FillSection fillSection) {
+    size_t fileSize = 0;
+    for (auto& imageSection : peFile.sections) {
+        fileSize = std::max<size_t>(fileSize, imageSection.header.pointerToRawData + imageSection.header.sizeOfRawData);
+    }
+    MappedOutputFile out(filePath, fileSize);
+    if (!out) {
+        return false;
+    }
+
+    // write headers at the start of the file
+    MemoryWriter headersWriter(out.data(), out.size());
+    writeHeaders(headersWriter, peFile);
+    if (!headersWriter) {
+        return false;
+    }
+
+    // write sections contents
+    std::atomic<bool> success = true;
+    parallelFor(peFile.sections.size(), threadCount, [&](size_t sectionNr) {
+        auto& header = peFile.sections[sectionNr].header;
+        if (header.sizeOfRawData == 0) {
+            return;
+        }
+        if (!fillSection(sectionNr, out.data() + header.pointerToRawData)) {
+            success = false;
+        }
+    });
+
+    return success;
+}
+
+/*
+    Serializes all headers into one buffer that covers everything before the first section in the file
+    (zero padded up to it).
+*/
+std::optional<std::vector<byte>> serializeHeaders(const PeFile& peFile) {
+    size_t sizeOfHeaders = DosHeader::Size() + PeHeader::Size32() + SectionHeader::Size() * peFile.sections.size();
+    if (std::holds_alternative<OptionalHeader64>(peFile.peHeader.optionalHeader)) {
+        sizeOfHeaders += PeHeader::Size64() - PeHeader::Size32();
+    }
+    size_t firstSectionInFile = 0;
+    for (auto& imageSection : peFile.sections) {
+        if (imageSection.header.sizeOfRawData > 0 && (firstSectionInFile == 0 || imageSection.header.pointerToRawData < firstSectionInFile)) {
+            firstSectionInFile = imageSection.header.pointerToRawData;
+        }
+    }
+    if (firstSectionInFile > 0) {
+        if (sizeOfHeaders > firstSectionInFile) {
+            return std::nullopt;
+        }
+        sizeOfHeaders = firstSectionInFile;
+    }
+
+    std::vector<byte> headers(sizeOfHeaders, 0);
+    MemoryWriter headersWriter(headers.data(), headers.size());
+    writeHeaders(headersWriter, peFile);
+    if (!headersWriter) {
+        return std::nullopt;
+    }
+    return headers;
+}
+
+/*
+    Writes the PE file (with contents of all sections already in PeSection::data) with a constant number
+    of system calls: all headers are serialized into one buffer, which is then written together with
+    the contents of all sections (and the zero padding between them) by a single gather write.
+*/
+bool writeGathered(const PeFile& peFile, GatherOutputFile& out) {
+    std::vector<const PeSection*> sectionsInFile;
+    for (auto& imageSection : peFile.sections) {
+        if (imageSection.header.sizeOfRawData > 0) {
+            if (imageSection.data.size() > imageSection.header.sizeOfRawData) {
+                return false;
+            }
+            sectionsInFile.push_back(&imageSection);
+        }
+    }
+    std::sort(begin(sectionsInFile), end(sectionsInFile), [](auto* a, auto* b) {
+        return a->header.pointerToRawData < b->header.pointerToRawData;
+    });
+
+    auto headers = serializeHeaders(peFile);
+    if (!headers) {
+        return false;
+    }
+
+    // padding blocks all point into one shared block of zeros
+    size_t maxPadding = 0;
+    for (size_t i = 0; i < sectionsInFile.size(); ++i) {
+        auto& header = sectionsInFile[i]->header;
+        size_t sectionEnd = (i + 1 < sectionsInFile.size()) ? sectionsInFile[i+1]->header.pointerToRawData : header.pointerToRawData + header.sizeOfRawData;
+        if (sectionEnd < header.pointerToRawData + sectionsInFile[i]->data.size()) {
+            return false;
+        }
+        maxPadding = std::max(maxPadding, sectionEnd - header.pointerToRawData - sectionsInFile[i]->data.size());
+    }
+    std::vector<byte> zeros(maxPadding, 0);
+
+    std::vector<ByteSpan> blocks;
+    blocks.reserve(1 + 2 * sectionsInFile.size());
+    blocks.emplace_back(headers->data(), headers->size());
+    for (size_t i = 0; i < sectionsInFile.size(); ++i) {
+        auto& header = sectionsInFile[i]->header;
+        auto& data = sectionsInFile[i]->data;
+        size_t sectionEnd = (i + 1 < sectionsInFile.size()) ? sectionsInFile[i+1]->header.pointerToRawData : header.pointerToRawData + header.sizeOfRawData;
+        blocks.emplace_back(data.data(), data.size());
+        blocks.emplace_back(zeros.data(), sectionEnd - header.pointerToRawData - data.size());
+    }
+
+    return out.write(blocks, 0);
 }
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+#include "usingTypes.h"
+#include "FileHeader.h"
+#include "PeHeader.h"
+#include "OptionalHeader32.h"
+#include "OptionalHeader64.h"
+#include "RelocationEngine.h"
+
+/*
+    Everything that differs between linking 32-bit (PE32) and 64-bit (PE32+) images. The linking pipeline
+    is a template over these, so both variants are instantiated at compile time.
+      Address    - type of addresses stored in the image (import lookup and address table entries)
+      Relocation - relocation kernels of the machine
+      writeJmp   - writes the 6 byte jmp instruction (at RVA jmpRVA) that jumps to the address stored
+                   in the import address table entry at RVA iatEntryRVA
+*/
+struct PeTarget32 {
+    static constexpr word Machine = FileHeader::Machine::I386;
+    static constexpr word Characteristics = FileHeader::Characteristic::Machine32Bit;
+    static constexpr const char* DefaultEntryPoint = "_main";
+    using OptionalHeader = OptionalHeader32;
+    using Address = dword;
+    using Relocation = RelocationTraitsI386;
+
+    static int peHeaderSize() {
+        return PeHeader::Size32();
+    }
+
+    static void writeJmp(byte* destination, dword /*jmpRVA*/, dword iatEntryRVA, qword imageBase) {
+        // jmp dword ptr [imageBase + iatEntryRVA]
+        *reinterpret_cast<word*>(destination) = 0x25ff;
+        *reinterpret_cast<dword*>(destination + 2) = static_cast<dword>(imageBase + iatEntryRVA);
+    }
+};
+
+struct PeTarget64 {
+    static constexpr word Machine = FileHeader::Machine::AMD64;
+    static constexpr word Characteristics = FileHeader::Characteristic::LargeAddressAware;
+    static constexpr const char* DefaultEntryPoint = "main";
+    using OptionalHeader = OptionalHeader64;
+    using Address = qword;
+    using Relocation = RelocationTraitsAmd64;
+
+    static int peHeaderSize() {
+        return PeHeader::Size64();
+    }
+
+    static void writeJmp(byte* destination, dword jmpRVA, dword iatEntryRVA, qword) {
+        // jmp qword ptr [rip + displacement] (relative to the end of the instruction)
+        *reinterpret_cast<word*>(destination) = 0x25ff;
+        *reinterpret_cast<dword*>(destination + 2) = iatEntryRVA - (jmpRVA + 6);
+    }
+};
\ No newline at end of file
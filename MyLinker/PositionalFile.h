@@ -0,0 +1,180 @@
+#pragma once
+#include "usingTypes.h"
+
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include "Windows.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+/*
+    Read-only file read at explicit positions (pread, ReadFile with OVERLAPPED offset) instead of through
+    a shared file position, so one opened file can be read by many threads at once.
+    Every read is one system call (or a few for reads that the system splits).
+*/
+class PositionalFile {
+public:
+    PositionalFile(const PositionalFile& other)=delete;
+    PositionalFile(const std::string& filePath) {
+        open(filePath);
+    }
+    virtual ~PositionalFile() {
+        close();
+    }
+
+    PositionalFile operator=(const PositionalFile& other)=delete;
+
+    bool open(const std::string& newFilePath) {
+        close();
+        filePath = newFilePath;
+#ifdef _WIN32
+        file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+        return file != INVALID_HANDLE_VALUE;
+#else
+        file = ::open(filePath.c_str(), O_RDONLY);
+        return file != -1;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (file != -1) ::close(file);
+        file = -1;
+#endif
+    }
+
+    /*
+        Reads size bytes starting at position into destination. Fails if the file ends before that.
+    */
+    bool read(size_t position, size_t size, byte* destination) const {
+        if (!*this) return false;
+        while (size > 0) {
+            countSystemCall();
+#ifdef _WIN32
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = static_cast<DWORD>(position);
+            overlapped.OffsetHigh = static_cast<DWORD>(static_cast<unsigned long long>(position) >> 32);
+            DWORD toRead = static_cast<DWORD>(std::min<size_t>(size, 1 << 30));
+            DWORD readBytes = 0;
+            if (!ReadFile(file, destination, toRead, &readBytes, &overlapped) || readBytes == 0) return false;
+#else
+            ssize_t readBytes = pread(file, destination, size, static_cast<off_t>(position));
+            if (readBytes < 0 && errno == EINTR) continue;
+            if (readBytes <= 0) return false;
+#endif
+            destination += readBytes;
+            position += readBytes;
+            size -= readBytes;
+        }
+        return true;
+    }
+
+    operator bool() const {
+#ifdef _WIN32
+        return file != INVALID_HANDLE_VALUE;
+#else
+        return file != -1;
+#endif
+    }
+
+    std::string getFilePath() {
+        return filePath;
+    }
+
+    /*
+        Number of read system calls done by all positional files.
+    */
+    static long long getTotalSystemCallCount() {
+        return totalSystemCallCount;
+    }
+
+private:
+    static void countSystemCall() {
+        totalSystemCallCount += 1;
+    }
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+#else
+    int file = -1;
+#endif
+    std::string filePath = "";
+    inline static std::atomic<long long> totalSystemCallCount = 0;
+};
+
+/*
+    Bounded set of opened positional files, shared by all object files whose contents are read lazily, so a link
+    of many object files doesn't keep one opened file per object file (and run into the limit of opened files per process).
+    Files are opened when they're read, the least recently used one is closed when more than maxOpenFiles are open
+    (reads that are still using it finish first).
+*/
+class PositionalFilePool {
+public:
+    PositionalFilePool(size_t maxOpenFiles) :
+        maxOpenFiles(maxOpenFiles)
+    {}
+
+    bool read(const std::string& filePath, size_t position, size_t size, byte* destination) {
+        auto file = acquire(filePath);
+        return file && file->read(position, size, destination);
+    }
+
+    /*
+        Pool shared by all object files.
+    */
+    static PositionalFilePool& global() {
+        static PositionalFilePool pool(64);
+        return pool;
+    }
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<PositionalFile>>;
+
+    std::shared_ptr<PositionalFile> acquire(const std::string& filePath) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (auto found = files.find(filePath); found != files.end()) {
+                recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, found->second);
+                return found->second->second;
+            }
+        }
+
+        // opened without holding the lock, so reads of files that are already open don't wait for it
+        auto file = std::make_shared<PositionalFile>(filePath);
+        if (!*file) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto found = files.find(filePath); found != files.end()) {
+            return found->second->second; // another thread opened it in the meantime
+        }
+        recentlyUsed.emplace_front(filePath, file);
+        files.emplace(filePath, recentlyUsed.begin());
+        if (recentlyUsed.size() > maxOpenFiles) {
+            files.erase(recentlyUsed.back().first);
+            recentlyUsed.pop_back();
+        }
+        return file;
+    }
+
+    size_t maxOpenFiles;
+    std::mutex mutex;
+    std::list<Entry> recentlyUsed; // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> files;
+};
\ No newline at end of file
@@ -0,0 +1,199 @@
+#pragma once
+#include "usingTypes.h"
+#include "FileHeader.h"
+#include "ObjectFile.h"
+#include "ByteSpan.h"
+
+#include <vector>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <cstring>
+
+/*
+    Relocation kernels of one machine type. Every supported relocation type is a kernel type with:
+      Type  - value of RelocationEntry::type
+      Patch - type of the patched value
+      value - constexpr function computing what is added to the patched value from the target RVA,
+              RVA of the patched bytes and the image base. The target is a qword so that absolute
+              addresses below the image base (negative RVAs) come out right in 64-bit patches
+    Relocations of type Ignored are skipped. isRelative tells if a relocation type is a 32-bit displacement
+    relative to the patched bytes (what calls and jumps to other functions use).
+*/
+struct RelocationTraitsI386 {
+    static constexpr word Machine = FileHeader::Machine::I386;
+    static constexpr word Ignored = RelocationEntry::TypeIntel386::Absolute;
+
+    struct Dir32va {
+        static constexpr word Type = RelocationEntry::TypeIntel386::Dir32va;
+        using Patch = dword;
+        static constexpr Patch value(qword target, dword, qword imageBase) {
+            return static_cast<Patch>(target + imageBase);
+        }
+    };
+    struct Dir32rva {
+        static constexpr word Type = RelocationEntry::TypeIntel386::Dir32rva;
+        using Patch = dword;
+        static constexpr Patch value(qword target, dword, qword) {
+            return static_cast<Patch>(target);
+        }
+    };
+    struct Rel32 {
+        static constexpr word Type = RelocationEntry::TypeIntel386::Rel32;
+        using Patch = dword;
+        static constexpr Patch value(qword target, dword place, qword) {
+            return static_cast<Patch>(target - place - sizeof(Patch)); // relative to the end of the patched value
+        }
+    };
+
+    using Kernels = std::tuple<Dir32va, Dir32rva, Rel32>;
+
+    static constexpr bool isRelative(word type) {
+        return type == RelocationEntry::TypeIntel386::Rel32;
+    }
+};
+
+struct RelocationTraitsAmd64 {
+    static constexpr word Machine = FileHeader::Machine::AMD64;
+    static constexpr word Ignored = RelocationEntry::TypeAmd64::Amd64Absolute;
+
+    struct Addr64 {
+        static constexpr word Type = RelocationEntry::TypeAmd64::Addr64;
+        using Patch = qword;
+        static constexpr Patch value(qword target, dword, qword imageBase) {
+            return target + imageBase;
+        }
+    };
+    struct Addr32 {
+        static constexpr word Type = RelocationEntry::TypeAmd64::Addr32;
+        using Patch = dword;
+        static constexpr Patch value(qword target, dword, qword imageBase) {
+            return static_cast<Patch>(target + imageBase);
+        }
+    };
+    struct Addr32nb {
+        static constexpr word Type = RelocationEntry::TypeAmd64::Addr32nb;
+        using Patch = dword;
+        static constexpr Patch value(qword target, dword, qword) {
+            return static_cast<Patch>(target);
+        }
+    };
+    /*
+        Relative to the end of the patched value, plus Distance more bytes (instruction continues after it).
+    */
+    template<word RelocationType, dword Distance> struct Rel32 {
+        static constexpr word Type = RelocationType;
+        using Patch = dword;
+        static constexpr Patch value(qword target, dword place, qword) {
+            return static_cast<Patch>(target - place - sizeof(Patch) - Distance);
+        }
+    };
+
+    using Kernels = std::tuple<
+        Addr64, Addr32, Addr32nb,
+        Rel32<RelocationEntry::TypeAmd64::Amd64Rel32, 0>,
+        Rel32<RelocationEntry::TypeAmd64::Rel32_1, 1>,
+        Rel32<RelocationEntry::TypeAmd64::Rel32_2, 2>,
+        Rel32<RelocationEntry::TypeAmd64::Rel32_3, 3>,
+        Rel32<RelocationEntry::TypeAmd64::Rel32_4, 4>,
+        Rel32<RelocationEntry::TypeAmd64::Rel32_5, 5>
+    >;
+
+    static constexpr bool isRelative(word type) {
+        return type >= RelocationEntry::TypeAmd64::Amd64Rel32 && type <= RelocationEntry::TypeAmd64::Rel32_5;
+    }
+};
+
+/*
+    Applies relocations of one machine type in batches. Relocations are first sorted into one batch per
+    relocation type (add), then every batch goes through the loop of its kernel (apply), which has no
+    branches on the relocation type.
+*/
+template<typename Traits> class RelocationEngine {
+public:
+    using Kernels = typename Traits::Kernels;
+    static constexpr size_t KernelCount = std::tuple_size_v<Kernels>;
+
+    /*
+        Index of the kernel of relocation type (or -1 if the type isn't supported).
+    */
+    static int kernelIndex(word type) {
+        for (size_t i = 0; i < KernelCount; ++i) {
+            if (KernelTypes[i] == type) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+    static size_t patchSize(int kernel) {
+        return KernelPatchSizes[kernel];
+    }
+
+    void clear() {
+        for (auto& batch : batches) {
+            batch.offsets.clear();
+            batch.targets.clear();
+            batch.places.clear();
+        }
+    }
+
+    /*
+        Adds relocation of bytes at offset (in the data given to apply) with RVA place, pointing to target RVA.
+    */
+    void add(int kernel, dword offset, qword target, dword place) {
+        auto& batch = batches[kernel];
+        batch.offsets.push_back(offset);
+        batch.targets.push_back(target);
+        batch.places.push_back(place);
+    }
+
+    /*
+        Applies all added relocations to data.
+    */
+    void apply(byte* data, qword imageBase) const {
+        applyAll(data, imageBase, std::make_index_sequence<KernelCount>());
+    }
+
+    size_t size() const {
+        size_t count = 0;
+        for (auto& batch : batches) {
+            count += batch.offsets.size();
+        }
+        return count;
+    }
+
+private:
+    struct Batch {
+        std::vector<dword> offsets;
+        std::vector<qword> targets;
+        std::vector<dword> places;
+    };
+
+    template<size_t... I> static constexpr std::array<word, KernelCount> typesOf(std::index_sequence<I...>) {
+        return {std::tuple_element_t<I, Kernels>::Type...};
+    }
+    template<size_t... I> static constexpr std::array<size_t, KernelCount> patchSizesOf(std::index_sequence<I...>) {
+        return {sizeof(typename std::tuple_element_t<I, Kernels>::Patch)...};
+    }
+    static constexpr std::array<word, KernelCount> KernelTypes = typesOf(std::make_index_sequence<KernelCount>());
+    static constexpr std::array<size_t, KernelCount> KernelPatchSizes = patchSizesOf(std::make_index_sequence<KernelCount>());
+
+    template<size_t... I> void applyAll(byte* data, qword imageBase, std::index_sequence<I...>) const {
+        (applyBatch<std::tuple_element_t<I, Kernels>>(batches[I], data, imageBase), ...);
+    }
+
+    template<typename Kernel> static void applyBatch(const Batch& batch, byte* data, qword imageBase) {
+        using Patch = typename Kernel::Patch;
+        const dword* offsets = batch.offsets.data();
+        const qword* targets = batch.targets.data();
+        const dword* places = batch.places.data();
+        size_t count = batch.offsets.size();
+        for (size_t i = 0; i < count; ++i) {
+            byte* patched = data + offsets[i];
+            Patch value = loadValue<Patch>(patched) + Kernel::value(targets[i], places[i], imageBase);
+            memcpy(patched, &value, sizeof(Patch));
+        }
+    }
+
+    std::array<Batch, KernelCount> batches;
+};
\ No newline at end of file
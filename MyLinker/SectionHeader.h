@@ -28,6 +28,7 @@ struct SectionHeader {
         Allign2048Byte              = 0x00C00000, // Align data on 2048-byte boundary. Valid only for object files. 
         Allign4096Byte              = 0x00D00000, // Align data on 4096-byte boundary. Valid only for object files. 
         Allign8192Byte              = 0x00E00000, // Align data on 8192-byte boundary. Valid only for object files. 
+        AllignMask                  = 0x00F00000, // Bits holding one of the Allign*Byte values. 
         ContainsExtendedRelocations = 0x01000000, // The section contains extended relocations. 
         CanDiscard                  = 0x02000000, // The section can be discarded as needed. 
         NotCached                   = 0x04000000, // The section cannot be cached. 
@@ -52,6 +53,18 @@ struct SectionHeader {
     static int Size() {
         return 40;
     }
+
+    /*
+        Alignment of the section contents in bytes, given by the Allign*Byte value (object files only).
+        Sections without it are aligned on 16 bytes.
+    */
+    dword alignment() const {
+        dword alignmentValue = (characteristics & Characteristic::AllignMask) >> 20;
+        if (alignmentValue == 0) {
+            return (characteristics & Characteristic::NoPadding) ? 1 : 16;
+        }
+        return dword(1) << (alignmentValue - 1);
+    }
 };
 
 template<typename Reader> std::optional<SectionHeader> readSectionHeader(Reader& reader) {
@@ -0,0 +1,101 @@
+#pragma once
+#include "usingTypes.h"
+#include "ByteSpan.h"
+
+#include <string>
+#include <optional>
+#include <cstring>
+
+/*
+    Reader over bytes that are already in memory (archive members, cached inputs, test data).
+    Provides the same reading interface as BinaryFile and MappedFile, with every read bounds checked
+    against the span. The viewed memory is owned by the caller and has to outlive the reader
+    (and everything read from it with readView).
+*/
+class SpanReader {
+public:
+    SpanReader(ByteSpan bytes, const std::string& name="") :
+        bytes(bytes),
+        name(name)
+    {}
+
+    void clearFail() {
+        failFlag = false;
+    }
+
+    void setPosition(long newPosition) {
+        clearFail();
+        position = newPosition;
+    }
+    long getPosition() {
+        return static_cast<long>(position);
+    }
+
+    bool read(char* resultBuffer, int sizeInBytes) {
+        if (!*this) return false;
+        if (sizeInBytes < 0 || position > bytes.size() || static_cast<size_t>(sizeInBytes) > bytes.size() - position) {
+            failFlag = true;
+            return false;
+        }
+        memcpy(resultBuffer, bytes.data() + position, sizeInBytes);
+        position += sizeInBytes;
+        return true;
+    }
+    template<typename T, int Size> bool read(T (&resultBuffer)[Size]) {
+        return read(reinterpret_cast<char*>(resultBuffer), Size * sizeof(T));
+    }
+    template<typename T> std::optional<T> read() {
+        T result;
+        if (read(reinterpret_cast<char*>(&result), sizeof(T))) {
+            return result;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    /*
+        Returns a view of the next sizeInBytes bytes without copying them.
+    */
+    std::optional<ByteSpan> readView(int sizeInBytes) {
+        if (!*this) return std::nullopt;
+        if (sizeInBytes < 0 || position > bytes.size() || static_cast<size_t>(sizeInBytes) > bytes.size() - position) {
+            failFlag = true;
+            return std::nullopt;
+        }
+        auto result = bytes.subspan(position, sizeInBytes);
+        position += sizeInBytes;
+        return result;
+    }
+
+    /*
+        All bytes the reader reads from.
+    */
+    ByteSpan contents() const {
+        return bytes;
+    }
+
+    template<typename T> SpanReader& operator>>(T& value) {
+        auto readResult = read<T>();
+        if (readResult) value = *readResult;
+        return *this;
+    }
+    template<typename T, int Size> SpanReader& operator>>(T (&array)[Size]) {
+        read(array);
+        return *this;
+    }
+
+    operator bool() {
+        return !failFlag;
+    }
+
+    // name of the input (used only in messages)
+    std::string getFilePath() {
+        return name;
+    }
+
+private:
+    ByteSpan bytes;
+    std::string name = "";
+    size_t position = 0;
+    bool failFlag = false;
+};
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include "usingTypes.h"
+#include "ByteSpan.h"
+
+#include <optional>
+#include <string_view>
+#include <cstring>
+
+/*
+    COFF string table (follows the symbol table in object files).
+    Long names are referenced by their byte offset from the beginning of the table,
+    where the first 4 bytes of the table are its size. Strings are null terminated.
+
+    The table is kept as one block of bytes and names are returned as views into it,
+    so lookups are O(1) and don't allocate.
+*/
+class StringTable {
+public:
+    StringTable() = default;
+    StringTable(ByteSpan strings) :
+        strings(strings)
+    {}
+
+    /*
+        Size of the table in bytes (including the size field).
+    */
+    dword size() const {
+        return static_cast<dword>(strings.size()) + SizeFieldSize;
+    }
+
+    /*
+        Table contents after the size field.
+    */
+    ByteSpan contents() const {
+        return strings;
+    }
+
+    std::optional<std::string_view> at(dword offset) const {
+        if (offset < SizeFieldSize || offset >= size()) {
+            return std::nullopt;
+        }
+        const char* begin = reinterpret_cast<const char*>(strings.data()) + (offset - SizeFieldSize);
+        size_t maxLength = size() - offset;
+        auto* terminator = static_cast<const char*>(memchr(begin, 0, maxLength));
+        return std::string_view(begin, terminator ? terminator - begin : maxLength);
+    }
+
+    static constexpr dword SizeFieldSize = 4;
+
+private:
+    ByteSpan strings; // table contents after the size field
+};
\ No newline at end of file
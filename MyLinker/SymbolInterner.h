@@ -0,0 +1,70 @@
+#pragma once
+#include "usingTypes.h"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+using SymbolId = dword;
+constexpr SymbolId InvalidSymbolId = SymbolId(-1);
+
+/*
+    Gives every distinct symbol name a 32-bit id, so symbols can be compared and looked up by id
+    instead of hashing and comparing their names again and again.
+    Interning is thread safe (names are split between independently locked shards) - ids depend on the order
+    in which names get interned, so they're only good for identity, not for ordering.
+*/
+class SymbolInterner {
+public:
+    SymbolId intern(std::string_view name) {
+        size_t shardNr = std::hash<std::string_view>()(name) % ShardCount;
+        auto& shard = shards[shardNr];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (auto found = shard.ids.find(name); found != shard.ids.end()) {
+            return found->second;
+        }
+        SymbolId id = static_cast<SymbolId>(shard.names.size() * ShardCount + shardNr);
+        auto& storedName = shard.names.emplace_back(name);
+        shard.ids.emplace(storedName, id);
+        return id;
+    }
+
+    /*
+        Id of an already interned name (doesn't intern it).
+    */
+    std::optional<SymbolId> find(std::string_view name) {
+        auto& shard = shards[std::hash<std::string_view>()(name) % ShardCount];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (auto found = shard.ids.find(name); found != shard.ids.end()) {
+            return found->second;
+        }
+        return std::nullopt;
+    }
+
+    std::string_view name(SymbolId id) {
+        auto& shard = shards[id % ShardCount];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.names[id / ShardCount];
+    }
+
+    /*
+        Interner shared by all object files.
+    */
+    static SymbolInterner& global() {
+        static SymbolInterner interner;
+        return interner;
+    }
+
+private:
+    static constexpr size_t ShardCount = 64;
+
+    struct Shard {
+        std::mutex mutex;
+        std::deque<std::string> names; // deque never moves its elements, so views into them (map keys) stay valid
+        std::unordered_map<std::string_view, SymbolId> ids;
+    };
+    Shard shards[ShardCount];
+};
\ No newline at end of file
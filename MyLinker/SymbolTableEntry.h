@@ -1,5 +1,6 @@
 #pragma once
 #include "usingTypes.h"
+#include "ByteSpan.h"
 
 #include <optional>
 #include <variant>
@@ -74,81 +75,183 @@ struct StandardSymbol {
     word type;                // A number that represents type. Microsoft tools set this field to 0x20 (function) or 0x0 (not a function). 
     byte storageClass;        // An enumerated value that represents storage class. 
     byte numberOfAuxSymbols;  // The number of auxiliary symbol table entries that follow this record. 
+
+    static int Size() {
+        return 18;
+    }
 };
 
-using SymbolTableEntry = std::variant<
-    StandardSymbol, 
-    AuxiliarySymbol
->;
+/*
+    Decodes an auxiliary record (18 bytes) that follows the given standard symbol.
+    Returns nullopt for kinds of auxiliary records that aren't recognized.
+*/
+std::optional<AuxiliarySymbol> decodeAuxiliarySymbol(const StandardSymbol& standardSymbol, const byte* auxRecord) {
+    if (standardSymbol.storageClass == StandardSymbol::StorageClass::External
+        && standardSymbol.type == StandardSymbol::Type::IsFunction
+        && standardSymbol.sectionNumber > 0)
+    {
+        AuxiliarySymbolFunctionDefinition functionDefinition;
+        functionDefinition.tagIndex              = loadValue<dword>(auxRecord);
+        functionDefinition.totalSize             = loadValue<dword>(auxRecord + 4);
+        functionDefinition.pointerToLineNumber   = loadValue<dword>(auxRecord + 8);
+        functionDefinition.pointerToNextFunction = loadValue<dword>(auxRecord + 12);
+        return functionDefinition;
+    }
+    else if (standardSymbol.storageClass == StandardSymbol::StorageClass::Function) {
+        AuxiliarySymbolFunctionBeginEndSymbols functionBeginEndSymbols;
+        functionBeginEndSymbols.lineNumber            = loadValue<word>(auxRecord + 4);
+        functionBeginEndSymbols.pointerToNextFunction = loadValue<dword>(auxRecord + 12);
+        return functionBeginEndSymbols;
+    }
+    else if (standardSymbol.storageClass == StandardSymbol::StorageClass::External
+        && standardSymbol.sectionNumber == StandardSymbol::SpecialSectionNumberValues::SymbolUndefined
+        && standardSymbol.value == 0) 
+    {
+        AuxiliarySymbolWeakExternals weakExternals;
+        weakExternals.tagIndex        = loadValue<dword>(auxRecord);
+        weakExternals.characteristics = loadValue<dword>(auxRecord + 4);
+        return weakExternals;
+    }
+    else if (standardSymbol.storageClass == StandardSymbol::StorageClass::File) {
+        AuxiliarySymbolFile file;
+        memcpy(file.fileName, auxRecord, sizeof(file.fileName));
+        return file;
+    }
+    else if (standardSymbol.storageClass == StandardSymbol::StorageClass::Static) {
+        AuxiliarySymbolSectionDefinition sectionDefinition;
+        sectionDefinition.length              = loadValue<dword>(auxRecord);
+        sectionDefinition.numberOfRelocations = loadValue<word>(auxRecord + 4);
+        sectionDefinition.numberOfLinenumbers = loadValue<word>(auxRecord + 6);
+        sectionDefinition.checkSum            = loadValue<dword>(auxRecord + 8);
+        sectionDefinition.number              = loadValue<word>(auxRecord + 12);
+        sectionDefinition.selection           = auxRecord[14];
+        return sectionDefinition;
+    }
+    return std::nullopt;
+}
 
+/*
+    Symbol table of an object file stored as columns (struct of arrays), one row per 18 byte record,
+    so rows are indexed the same way as in relocations (auxiliary records take rows too).
+    Loops over symbols only touch the columns they need. Auxiliary records aren't decoded up front -
+    their bytes are spread over the columns like any other record and get decoded on demand.
+*/
+class SymbolTable {
+public:
+    size_t size() const {
+        return names.size();
+    }
 
-template<typename Reader> bool readSymbolTableEntry(Reader& reader, std::vector<SymbolTableEntry>& symbolTable, int& i) {
-    StandardSymbol standardSymbol;
-
-    reader >> standardSymbol.name;
-    reader >> standardSymbol.value;
-    reader >> standardSymbol.sectionNumber;
-    reader >> standardSymbol.type;
-    reader >> standardSymbol.storageClass;
-    reader >> standardSymbol.numberOfAuxSymbols;
-
-    i += standardSymbol.numberOfAuxSymbols;
-
-    symbolTable.emplace_back(standardSymbol);
-
-    for (int i = 0; i < standardSymbol.numberOfAuxSymbols; ++i) {
-        if (standardSymbol.storageClass == StandardSymbol::StorageClass::External
-            && standardSymbol.type == StandardSymbol::Type::IsFunction
-            && standardSymbol.sectionNumber > 0)
-        {
-            AuxiliarySymbolFunctionDefinition functionDefinition;
-            reader >> functionDefinition.tagIndex;
-            reader >> functionDefinition.totalSize;
-            reader >> functionDefinition.pointerToLineNumber;
-            reader >> functionDefinition.pointerToNextFunction;
-            byte b;
-            reader >> b >> b;
-            symbolTable.emplace_back(functionDefinition);
-        }
-        else if (standardSymbol.storageClass == StandardSymbol::StorageClass::Function) {
-            AuxiliarySymbolFunctionBeginEndSymbols functionBeginEndSymbols;
-            byte b;
-            reader >> b >> b >> b >> b;
-            reader >> functionBeginEndSymbols.lineNumber;
-            reader >> b >> b >> b >> b >> b >> b;
-            reader >> functionBeginEndSymbols.pointerToNextFunction;
-            reader >> b >> b;
-            symbolTable.emplace_back(functionBeginEndSymbols);
+    bool isAuxiliary(size_t index) const {
+        return auxiliary[index];
+    }
+    const std::array<byte, 8>& name(size_t index) const {
+        return names[index];
+    }
+    dword value(size_t index) const {
+        return values[index];
+    }
+    word sectionNumber(size_t index) const {
+        return sectionNumbers[index];
+    }
+    word type(size_t index) const {
+        return types[index];
+    }
+    byte storageClass(size_t index) const {
+        return storageClasses[index];
+    }
+    byte numberOfAuxSymbols(size_t index) const {
+        return numbersOfAuxSymbols[index];
+    }
+
+    StandardSymbol standardSymbol(size_t index) const {
+        StandardSymbol symbol;
+        symbol.name               = names[index];
+        symbol.value              = values[index];
+        symbol.sectionNumber      = sectionNumbers[index];
+        symbol.type               = types[index];
+        symbol.storageClass       = storageClasses[index];
+        symbol.numberOfAuxSymbols = numbersOfAuxSymbols[index];
+        return symbol;
+    }
+
+    /*
+        Decodes the auxiliary record in the given row (nullopt if it's a standard symbol or of unknown kind).
+    */
+    std::optional<AuxiliarySymbol> auxiliarySymbol(size_t index) const {
+        if (!isAuxiliary(index)) {
+            return std::nullopt;
         }
-        else if (standardSymbol.storageClass == StandardSymbol::StorageClass::External
-            && standardSymbol.sectionNumber == StandardSymbol::SpecialSectionNumberValues::SymbolUndefined
-            && standardSymbol.value == 0) 
-        {
-            AuxiliarySymbolWeakExternals weakExternals;
-            reader >> weakExternals.tagIndex;
-            reader >> weakExternals.characteristics;
-            byte b;
-            reader >> b >> b >> b >> b >> b >> b >> b >> b >> b >> b;
-            symbolTable.emplace_back(weakExternals);
+        size_t ownerIndex = index;
+        while (ownerIndex > 0 && isAuxiliary(ownerIndex)) {
+            ownerIndex -= 1;
         }
-        else if (standardSymbol.storageClass == StandardSymbol::StorageClass::File) {
-            AuxiliarySymbolFile file;
-            reader >> file.fileName;
-            symbolTable.emplace_back(file);
+        byte record[18];
+        memcpy(record, names[index].data(), 8);
+        memcpy(record + 8, &values[index], 4);
+        memcpy(record + 12, &sectionNumbers[index], 2);
+        memcpy(record + 14, &types[index], 2);
+        record[16] = storageClasses[index];
+        record[17] = numbersOfAuxSymbols[index];
+        return decodeAuxiliarySymbol(standardSymbol(ownerIndex), record);
+    }
+
+    /*
+        Bytes of memory taken by the columns.
+    */
+    size_t memoryUsage() const {
+        return names.capacity() * sizeof(names[0]) + values.capacity() * sizeof(dword)
+             + sectionNumbers.capacity() * sizeof(word) + types.capacity() * sizeof(word)
+             + storageClasses.capacity() + numbersOfAuxSymbols.capacity() + auxiliary.capacity() / 8;
+    }
+
+    friend bool decodeSymbolTable(ByteSpan data, SymbolTable& symbolTable);
+
+private:
+    std::vector<std::array<byte, 8>> names;
+    std::vector<dword> values;
+    std::vector<word> sectionNumbers;
+    std::vector<word> types;
+    std::vector<byte> storageClasses;
+    std::vector<byte> numbersOfAuxSymbols;
+    std::vector<bool> auxiliary;
+};
+
+/*
+    Decodes the whole symbol table that was read into memory in one go (records are 18 bytes each).
+*/
+bool decodeSymbolTable(ByteSpan data, SymbolTable& symbolTable) {
+    size_t numberOfRecords = data.size() / StandardSymbol::Size();
+    symbolTable.names.resize(numberOfRecords);
+    symbolTable.values.resize(numberOfRecords);
+    symbolTable.sectionNumbers.resize(numberOfRecords);
+    symbolTable.types.resize(numberOfRecords);
+    symbolTable.storageClasses.resize(numberOfRecords);
+    symbolTable.numbersOfAuxSymbols.resize(numberOfRecords);
+    symbolTable.auxiliary.assign(numberOfRecords, false);
+
+    const byte* record = data.data();
+    for (size_t i = 0; i < numberOfRecords; ++i, record += StandardSymbol::Size()) {
+        memcpy(symbolTable.names[i].data(), record, 8);
+        symbolTable.values[i]              = loadValue<dword>(record + 8);
+        symbolTable.sectionNumbers[i]      = loadValue<word>(record + 12);
+        symbolTable.types[i]               = loadValue<word>(record + 14);
+        symbolTable.storageClasses[i]      = record[16];
+        symbolTable.numbersOfAuxSymbols[i] = record[17];
+    }
+
+    // mark auxiliary records (they follow their standard symbol)
+    size_t i = 0;
+    while (i < numberOfRecords) {
+        size_t numberOfAuxSymbols = symbolTable.numbersOfAuxSymbols[i];
+        if (i + 1 + numberOfAuxSymbols > numberOfRecords) {
+            return false;
         }
-        else if (standardSymbol.storageClass == StandardSymbol::StorageClass::Static) {
-            AuxiliarySymbolSectionDefinition sectionDefinition;
-            reader >> sectionDefinition.length;
-            reader >> sectionDefinition.numberOfRelocations;
-            reader >> sectionDefinition.numberOfLinenumbers;
-            reader >> sectionDefinition.checkSum;
-            reader >> sectionDefinition.number;
-            reader >> sectionDefinition.selection;
-            byte b;
-            reader >> b >> b >> b;
-            symbolTable.emplace_back(sectionDefinition);
+        for (size_t auxIndex = i + 1; auxIndex <= i + numberOfAuxSymbols; ++auxIndex) {
+            symbolTable.auxiliary[auxIndex] = true;
         }
+        i += 1 + numberOfAuxSymbols;
     }
 
-    return reader;
+    return true;
 }
\ No newline at end of file
@@ -11,16 +11,29 @@
 #include "SymbolTableEntry.h"
 #include "errorMessages.h"
 #include "BinaryFile.h"
+#include "BufferedBinaryFile.h"
+#include "MappedFile.h"
+#include "SpanReader.h"
+#include "FilePrefetcher.h"
+#include "MemoryUsage.h"
+#include "ParallelFor.h"
+#include "ConcurrentSymbolTable.h"
+#include "RelocationEngine.h"
+#include "PeTarget.h"
+#include "CodePadding.h"
+#include "CallGraphLayout.h"
 
 #include <iostream>
 #include <fstream>
 #include <variant>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <ctime>
 #include <unordered_map>
 #include <unordered_set>
 #include <numeric>
+#include <chrono>
 
 #define NOMINMAX
 #include "Windows.h"
@@ -32,6 +45,9 @@ dword getPageSize() {
     return si.dwPageSize;
 }
 
+enum class InputReader { Mapped, Buffered, Stream };
+enum class OutputWriter { Mapped, Gather, Stream };
+
 struct ProgramOptions {
     int sizeOfStackReserve = 0x200000;
     int sizeOfStackCommit  = 0x1000;
@@ -40,9 +56,21 @@ struct ProgramOptions {
     int sectionAllign = getPageSize();
     int fileAllign = 0x200;
     int imageBase = 0x400000;
-    std::string entryPoint = "_main";
+    std::string entryPoint = ""; // empty means default entry point of the machine
     std::string outputFileName = "a.exe";
     bool showDllWarnings = false;
+    bool showStats = false;
+    bool streaming = false;
+    int prefetchDepth = 0;
+    int prefetchBytes = 64 * 1024 * 1024;
+    InputReader inputReader = InputReader::Mapped;
+    OutputWriter outputWriter = OutputWriter::Mapped;
+    int threadCount = defaultThreadCount();
+    int relocationBenchmarkRounds = 0;
+    CodePadding codePadding = CodePadding::Int3;
+    bool packData = false;
+    std::string orderFileName = ""; // empty means no order file
+    bool callGraphOrder = false;
     word subsystem = OptionalHeader32::Subsystem::WindowsCui;
     bool onlyShowHelp = false;
     std::vector<std::string> objFileNames;
@@ -64,6 +92,7 @@ bool programOptionsReadSingleIntArg(const std::vector<char*>& argv, size_t& i, c
 }
 std::optional<ProgramOptions> getProgramOptions(char* program, const std::vector<char*>& argv) {
     ProgramOptions options;
+    bool inputReaderChosen = false;
 
     size_t i = 0;
     while (i < argv.size()) {
@@ -80,7 +109,7 @@ std::optional<ProgramOptions> getProgramOptions(char* program, const std::vector
             std::cout << "                   [default: N=512]\n";
             std::cout << "-base N          : virtual address after loading (N is multiple of 65536)\n"; 
             std::cout << "                   [default: N=0x400000]\n";
-            std::cout << "-entry FUN       : entry point (FUN is function name) [default: FUN = '_main']\n";
+            std::cout << "-entry FUN       : entry point (FUN is function name) [default: FUN = '_main' (32-bit), 'main' (64-bit)]\n";
             std::cout << "-out PATH        : path to output file (PATH - chosen path) [default: PATH=a.exe]\n";
             std::cout << "-subsystem STR   : subsystem. possible values for STR:\n";
             std::cout << "                       native, winBoot, winGUI, winCUI, winCE,\n";
@@ -88,6 +117,40 @@ std::optional<ProgramOptions> getProgramOptions(char* program, const std::vector
             std::cout << "                       efiRuntimeDriver, efiRom\n";
             std::cout << "                   [default: STR='winCUI']\n";
             std::cout << "-dllwarn         : show warnings if non-perfect dll symbol matching occured\n";
+            std::cout << "-stats           : print link statistics (parse time, peak memory usage, read/write system calls,\n";
+            std::cout << "                   how much of the order file was used, cross-page calls with -callGraphOrder)\n";
+            std::cout << "-reader STR      : how object files are read. possible values for STR:\n";
+            std::cout << "                       mapped (memory mapped), buffered (positional buffered reads),\n";
+            std::cout << "                       stream (std::fstream)\n";
+            std::cout << "                   [default: STR='mapped']\n";
+            std::cout << "-writer STR      : how the output file is written. possible values for STR:\n";
+            std::cout << "                       mapped (memory mapped, sections filled in parallel),\n";
+            std::cout << "                       gather (headers and sections written by one vectored write),\n";
+            std::cout << "                       stream (std::fstream)\n";
+            std::cout << "                   [default: STR='mapped']\n";
+            std::cout << "-threads N       : number of threads used for parsing object files and filling output sections\n";
+            std::cout << "                   (N - natural number) [default: N=number of hardware threads]\n";
+            std::cout << "-prefetch N      : load up to N next object files on a background thread while the current one\n";
+            std::cout << "                   is parsed (N - natural number, 0 disables) [default: N=0]\n";
+            std::cout << "-prefetchBytes N : limit of bytes of prefetched files waiting to be parsed\n";
+            std::cout << "                   (N - natural number) [default: N=0x4000000]\n";
+            std::cout << "-streaming       : link one output section at a time and release object files as soon as\n";
+            std::cout << "                   no later section needs them (lowest memory usage)\n";
+            std::cout << "                   [default reader: 'buffered']\n";
+            std::cout << "-codePadding STR : what gaps between aligned object sections in code are filled with\n";
+            std::cout << "                   (STR - one of the following):\n";
+            std::cout << "                       int3 (0xCC bytes)\n";
+            std::cout << "                       nop  (multi-byte nop instructions)\n";
+            std::cout << "                   [default: STR='int3']\n";
+            std::cout << "-packData        : order object sections of data sections by alignment (largest first)\n";
+            std::cout << "                   to minimize padding between them\n";
+            std::cout << "-order FILE      : place object sections defining symbols listed in FILE (one name per line) first\n";
+            std::cout << "                   in their output sections, in the order of the list (grouped sections\n";
+            std::cout << "                   \"name$suffix\" are still ordered by suffix first)\n";
+            std::cout << "-callGraphOrder  : order code object sections so that functions calling each other are on\n";
+            std::cout << "                   the same pages (call graph built from relative relocations, not used with -order)\n";
+            std::cout << "-benchmarkRelocations N : apply relocations of all object sections N more times (on one thread,\n";
+            std::cout << "                   to scratch memory) and print relocations per second [default: N=0]\n";
             std::cout << "-dll DLL_FILE    : path to linked .dll\n";
             std::cout << "OBJ_FILE         : path to linked .obj\n";
             return options;
@@ -144,6 +207,92 @@ std::optional<ProgramOptions> getProgramOptions(char* program, const std::vector
         } else if (!strcmp("-dllwarn", argv[i])) {
             i += 1;
             options.showDllWarnings = true;
+        } else if (!strcmp("-stats", argv[i])) {
+            i += 1;
+            options.showStats = true;
+        } else if (!strcmp("-threads", argv[i])) {
+            if (!programOptionsReadSingleIntArg(argv, i, "-threads", options.threadCount)) return std::nullopt;
+            if (options.threadCount <= 0) {
+                return errorMessageOpt("[-threads] value needs to be positive");
+            }
+        } else if (!strcmp("-prefetch", argv[i])) {
+            if (!programOptionsReadSingleIntArg(argv, i, "-prefetch", options.prefetchDepth)) return std::nullopt;
+            if (options.prefetchDepth < 0) {
+                return errorMessageOpt("[-prefetch] value can't be negative");
+            }
+        } else if (!strcmp("-prefetchBytes", argv[i])) {
+            if (!programOptionsReadSingleIntArg(argv, i, "-prefetchBytes", options.prefetchBytes)) return std::nullopt;
+            if (options.prefetchBytes <= 0) {
+                return errorMessageOpt("[-prefetchBytes] value needs to be positive");
+            }
+        } else if (!strcmp("-benchmarkRelocations", argv[i])) {
+            if (!programOptionsReadSingleIntArg(argv, i, "-benchmarkRelocations", options.relocationBenchmarkRounds)) return std::nullopt;
+            if (options.relocationBenchmarkRounds < 0) {
+                return errorMessageOpt("[-benchmarkRelocations] value can't be negative");
+            }
+        } else if (!strcmp("-streaming", argv[i])) {
+            i += 1;
+            options.streaming = true;
+        } else if (!strcmp("-reader", argv[i])) {
+            i += 1;
+            if (i >= argv.size()) {
+                return errorMessageOpt("expected 1 string argument for [-reader]");
+            }
+            static std::unordered_map<std::string, InputReader> argToInputReader = {
+                {"mapped",   InputReader::Mapped},
+                {"buffered", InputReader::Buffered},
+                {"stream",   InputReader::Stream}
+            };
+            std::string chosenReader = argv[i++];
+            if (auto found = argToInputReader.find(chosenReader); found != argToInputReader.end()) {
+                options.inputReader = found->second;
+                inputReaderChosen = true;
+            } else {
+                return errorMessageOpt("'" + chosenReader + "' is not a known reader (see -help)");
+            }
+        } else if (!strcmp("-codePadding", argv[i])) {
+            i += 1;
+            if (i >= argv.size()) {
+                return errorMessageOpt("expected 1 string argument for [-codePadding]");
+            }
+            static std::unordered_map<std::string, CodePadding> argToCodePadding = {
+                {"int3", CodePadding::Int3},
+                {"nop",  CodePadding::Nop}
+            };
+            std::string chosenPadding = argv[i++];
+            if (auto found = argToCodePadding.find(chosenPadding); found != argToCodePadding.end()) {
+                options.codePadding = found->second;
+            } else {
+                return errorMessageOpt("'" + chosenPadding + "' is not a known code padding (see -help)");
+            }
+        } else if (!strcmp("-order", argv[i])) {
+            i += 1;
+            if (i >= argv.size()) {
+                return errorMessageOpt("expected 1 string argument for [-order]");
+            }
+            options.orderFileName = argv[i++];
+        } else if (!strcmp("-callGraphOrder", argv[i])) {
+            i += 1;
+            options.callGraphOrder = true;
+        } else if (!strcmp("-packData", argv[i])) {
+            i += 1;
+            options.packData = true;
+        } else if (!strcmp("-writer", argv[i])) {
+            i += 1;
+            if (i >= argv.size()) {
+                return errorMessageOpt("expected 1 string argument for [-writer]");
+            }
+            static std::unordered_map<std::string, OutputWriter> argToOutputWriter = {
+                {"mapped", OutputWriter::Mapped},
+                {"gather", OutputWriter::Gather},
+                {"stream", OutputWriter::Stream}
+            };
+            std::string chosenWriter = argv[i++];
+            if (auto found = argToOutputWriter.find(chosenWriter); found != argToOutputWriter.end()) {
+                options.outputWriter = found->second;
+            } else {
+                return errorMessageOpt("'" + chosenWriter + "' is not a known writer (see -help)");
+            }
         } else if (!strcmp("-subsystem", argv[i])) {
             i += 1;
             if (i >= argv.size()) {
@@ -173,6 +322,15 @@ std::optional<ProgramOptions> getProgramOptions(char* program, const std::vector
         }
     }
 
+    if (options.streaming && !inputReaderChosen) {
+        // mapped object files would stay mapped until released
+        options.inputReader = InputReader::Buffered;
+    }
+    if (options.callGraphOrder && !options.orderFileName.empty()) {
+        warningMessage("[-callGraphOrder] isn't used when an order file is given with [-order]");
+        options.callGraphOrder = false;
+    }
+
     if (options.objFileNames.empty()) {
         return errorMessageOpt("no object files given");
     }
@@ -202,54 +360,15 @@ std::array<byte, 8> strToArray(const std::string& str) {
     }
     return arr;
 }
-std::string arrayToStr(const std::array<byte, 8>& arr) {
-    std::string str;
-
-    int i = 0;
-    while (i < 8 && arr[i] != '\0') {
-        str += arr[i++];
-    }
-
-    return str;
-}
-std::optional<std::string> getSymbolName(const std::array<byte, 8>& arr, const std::map<int, std::string>& stringTable) {
-    if (arr[0] == 0 && arr[1] == 0 && arr[2] == 0 && arr[3] == 0) {
-        int stringOffset = *reinterpret_cast<const int*>(&arr[4]);
-        if (auto str = stringTable.find(stringOffset); str != end(stringTable)) {
-            return str->second;
-        } else {
-            return std::nullopt;
-        }
-    } else {
-        return arrayToStr(arr);
-    }
-}
-
-struct ObjectSectionName {
-    const ObjectFile* obj;
-    std::array<byte, 8> name;
-
-    ObjectSectionName(const ObjectFile* obj, const std::array<byte, 8>& name) :
-        obj(obj),
-        name(name)
-    {}
-
-    bool operator==(const ObjectSectionName& other) const {
-        return obj == other.obj && name == other.name;
-    }
-};
-namespace std {
-    template <> struct hash<ObjectSectionName> {
-        std::size_t operator()(const ObjectSectionName& os) const {
-            return std::hash<const ObjectFile*>()(os.obj) ^ (std::hash<std::string>()(arrayToStr(os.name)) << 1);
-        }
-    };
-}
 
 struct PeSectionPosition {
     int sectionNr;
     int offset;
 
+    PeSectionPosition() :
+        sectionNr(0),
+        offset(0)
+    {}
     PeSectionPosition(const int sectionNr, const int offset) :
         sectionNr(sectionNr),
         offset(offset)
@@ -258,19 +377,43 @@ struct PeSectionPosition {
 
 struct ObjectSectionOffset {
     const ObjectFile* obj;
+    size_t objNr; // index of obj in the linked object files
+    const ObjectSection* section;
     int offset;
+    std::string_view groupSuffix; // suffix of a grouped section name ("name$suffix", points into obj), empty for others
 
-    ObjectSectionOffset(const ObjectFile* obj, const int offset) :
+    ObjectSectionOffset(const ObjectFile* obj, const size_t objNr, const ObjectSection* section, const int offset, std::string_view groupSuffix = std::string_view()) :
         obj(obj),
-        offset(offset)
+        objNr(objNr),
+        section(section),
+        offset(offset),
+        groupSuffix(groupSuffix)
     {}
 };
 
+/*
+    What a symbol referenced by relocations resolves to. Symbols are resolved once per object file
+    (into a table indexed like its symbol table), so applying relocations is plain indexing.
+*/
+struct ResolvedTarget {
+    enum class Kind : byte {
+        Unresolved, // not referenced by any relocation
+        Section,    // offset in section number sectionNr of the PE file
+        DllImport,  // jmp instruction (at RVA offset) calling function from dll. relocations are set to its address, not added to
+        Absolute,   // absolute address (offset) that isn't affected by layout
+    };
+
+    Kind kind = Kind::Unresolved;
+    int sectionNr = 0;
+    dword offset = 0;
+};
+
 struct Section {
     std::array<byte, 8> name;
-    std::vector<byte> data;
+    dword size = 0;
     std::vector<ObjectSectionOffset> objSections;
     dword characteristics;
+    bool grouped = false; // some object sections are grouped ("name$suffix"), so they have to be ordered by suffix
 
     bool operator<(const Section& other) {
         auto characteristicValue = [](auto characteristic) -> auto {
@@ -338,40 +481,236 @@ std::optional<std::pair<std::string, std::string>> tryFindDll(const std::string&
     return std::nullopt;
 }
 
-std::optional<PeFile> createPeFromObj(const std::vector<ObjectFile>& objFiles, ProgramOptions options) {
+/*
+    Symbol names listed in an order file, one per line (surrounding whitespace is ignored, so are empty lines).
+*/
+std::optional<std::vector<std::string>> readOrderFile(const std::string& fileName) {
+    std::ifstream file(fileName);
+    if (!file) {
+        return errorMessageOpt("couldn't open order file '" + fileName + "'");
+    }
+    std::vector<std::string> symbolNames;
+    std::string line;
+    while (std::getline(file, line)) {
+        auto first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos) {
+            continue;
+        }
+        auto last = line.find_last_not_of(" \t\r");
+        symbolNames.push_back(line.substr(first, last - first + 1));
+    }
+    return symbolNames;
+}
+
+/*
+    Object file sections that make up one section of the PE file (and the size of their contents).
+    Sections created by the linker itself (dll jumps, imports) have no object sections - their contents are
+    built during layout and stored directly in the PeSection.
+*/
+struct PeSectionContents {
+    dword size = 0;
+    std::vector<ObjectSectionOffset> objSections;
+};
+
+/*
+    PE file with all headers and addresses final, but without contents of the sections made from object files.
+    These are produced by fillPeSection, which only reads the layout, so sections can be filled in parallel
+    and straight into their final location (e.g. memory mapped output file).
+*/
+struct PeLayout {
     PeFile peFile;
+    std::vector<PeSectionContents> sectionContents; // for every section of peFile
+    std::vector<std::vector<ResolvedTarget>> resolvedSymbols; // for every object file, indexed by symbol table index
+    CodePadding codePadding;
+    int imageBase;
+};
+
+template<typename Target> std::optional<PeLayout> layoutPeFromObj(const std::vector<ObjectFile>& objFiles, ProgramOptions options) {
+    using Address = typename Target::Address;
+    PeLayout layout;
+    auto& peFile = layout.peFile;
+    layout.imageBase = options.imageBase;
+    layout.codePadding = options.codePadding;
 
-    // get all sections from all input object files (concatenate sections with the same name)
-    std::unordered_map<std::string, Section> sectionsMap;
     for (auto& obj : objFiles) {
+        if (obj.fileHeader.machine != Target::Machine && obj.fileHeader.machine != FileHeader::Machine::Unknown) {
+            return errorMessageOpt("obj files have different machine types");
+        }
+    }
+
+    // get all sections from all input object files (sections with the same name are concatenated, grouped sections
+    // "name$suffix" are merged into section "name"; contents are copied later, straight into the PE sections).
+    // discarded sections (debug information, LinkRemove) are left out
+    std::unordered_map<std::string, Section> sectionsMap;
+    for (size_t objNr = 0; objNr < objFiles.size(); ++objNr) {
+        auto& obj = objFiles[objNr];
         for (auto& objSection : obj.sections) {
-            auto sectionName = arrayToStr(objSection.header.name);
+            if (objSection.discarded) {
+                continue;
+            }
+            auto objSectionName = getSectionName(objSection.header, obj.stringTable);
+            if (!objSectionName) {
+                return errorMessageOpt("obj file is malformed - couldn't read section name");
+            }
+            auto [groupName, groupSuffix] = splitGroupedSectionName(*objSectionName);
+            auto sectionName = std::string(groupName);
+            if (sectionName.size() > 8) {
+                return errorMessageOpt("section name '" + sectionName + "' is longer than 8 characters, which isn't supported in images");
+            }
             if (auto existingSection = sectionsMap.find(sectionName); existingSection != sectionsMap.end()) {
-                auto& peSection = existingSection->second;
-                peSection.objSections.emplace_back(&obj, peSection.data.size());
-                for (byte b : objSection.data) {
-                    peSection.data.emplace_back(b);
-                }
+                existingSection->second.objSections.emplace_back(&obj, objNr, &objSection, 0, groupSuffix);
+                existingSection->second.grouped |= !groupSuffix.empty();
             } else {
                 Section peSection;
-                peSection.data = objSection.data;
                 peSection.characteristics = objSection.header.characteristics;
-                peSection.objSections.emplace_back(&obj, 0);
-                peSection.name = objSection.header.name;
+                peSection.objSections.emplace_back(&obj, objNr, &objSection, 0, groupSuffix);
+                peSection.name = strToArray(sectionName);
+                peSection.grouped = !groupSuffix.empty();
                 sectionsMap.emplace(sectionName, peSection);
             }
         }
     }
 
+    // object sections defining symbols from the order file get the position of the first such symbol in the list,
+    // other sections stay unranked. a symbol defined more than once ranks its first definition (the rest is a link error anyway)
+    constexpr dword Unranked = dword(-1);
+    std::vector<std::vector<dword>> objSectionRanks(objFiles.size()); // for every section of every object file
+    if (!options.orderFileName.empty()) {
+        auto orderedSymbols = readOrderFile(options.orderFileName);
+        if (!orderedSymbols) {
+            return std::nullopt;
+        }
+        std::unordered_map<SymbolId, dword> symbolRanks;
+        for (size_t i = 0; i < orderedSymbols->size(); ++i) {
+            if (auto id = SymbolInterner::global().find((*orderedSymbols)[i])) {
+                symbolRanks.emplace(*id, static_cast<dword>(i));
+            }
+        }
+        std::vector<std::vector<dword>> foundSymbols(objFiles.size()); // ranks of symbols defined by every object file
+        parallelFor(objFiles.size(), options.threadCount, [&](size_t objNr) {
+            auto& obj = objFiles[objNr];
+            auto& ranks = objSectionRanks[objNr];
+            ranks.assign(obj.sections.size(), Unranked);
+            forEachDefinedExternal(obj, [&](size_t symbolIndex, size_t sectionIndex) {
+                if (auto found = symbolRanks.find(obj.symbolNameIds[symbolIndex]); found != symbolRanks.end()) {
+                    ranks[sectionIndex] = std::min(ranks[sectionIndex], found->second);
+                    if (options.showStats) {
+                        foundSymbols[objNr].push_back(found->second);
+                    }
+                }
+            });
+        });
+
+        // how much of the order file was used is a link statistic
+        if (options.showStats) {
+            std::vector<bool> symbolFound(orderedSymbols->size(), false);
+            for (auto& ranks : foundSymbols) {
+                for (auto rank : ranks) {
+                    symbolFound[rank] = true;
+                }
+            }
+            size_t placedBytes = 0;
+            for (size_t objNr = 0; objNr < objFiles.size(); ++objNr) {
+                for (size_t sectionIndex = 0; sectionIndex < objSectionRanks[objNr].size(); ++sectionIndex) {
+                    if (objSectionRanks[objNr][sectionIndex] != Unranked) {
+                        placedBytes += objFiles[objNr].sections[sectionIndex].header.sizeOfRawData;
+                    }
+                }
+            }
+            std::cout << "order file: " << std::count(begin(symbolFound), end(symbolFound), true) << " of "
+                      << orderedSymbols->size() << " symbols found, " << placedBytes << " bytes placed\n";
+        }
+    }
+    auto rank = [&](const ObjectSectionOffset& objSection) {
+        auto& ranks = objSectionRanks[objSection.objNr];
+        return ranks.empty() ? Unranked : ranks[objSection.section - objSection.obj->sections.data()];
+    };
+
+    // without an order file, code object sections can be ordered by clustering the call graph
+    ObjectCallGraph callGraph;
+    if (options.callGraphOrder) {
+        callGraph.build<typename Target::Relocation>(objFiles, options.threadCount, getPageSize());
+    }
+    auto callGraphRank = [&](const ObjectSectionOffset& objSection) {
+        return callGraph.rank(objSection.objNr, objSection.section - objSection.obj->sections.data());
+    };
+
+    // order object sections: object sections of grouped sections by suffix first (lexically, keeping the order of
+    // object files for equal suffixes), then ranked ones (by rank) before the rest among equal suffixes, then code object
+    // sections by their call graph rank. with packData, object sections of data sections are also ordered by alignment
+    // (among equal suffixes and ranks), so smaller ones fill the space that would be padding otherwise. then place them
+    // at offsets aligned as their headers require
+    auto orderAndPlace = [&](Section& section, bool useCallGraph) {
+        bool packed = options.packData && !(section.characteristics & SectionHeader::Characteristic::ContainsCode);
+        if (!options.orderFileName.empty() || section.grouped || packed || useCallGraph) {
+            std::stable_sort(begin(section.objSections), end(section.objSections), [&](const ObjectSectionOffset& a, const ObjectSectionOffset& b) {
+                if (section.grouped && a.groupSuffix != b.groupSuffix) {
+                    return a.groupSuffix < b.groupSuffix;
+                }
+                auto rankA = rank(a);
+                auto rankB = rank(b);
+                if (rankA != rankB) {
+                    return rankA < rankB;
+                }
+                if (useCallGraph) {
+                    auto callGraphRankA = callGraphRank(a);
+                    auto callGraphRankB = callGraphRank(b);
+                    if (callGraphRankA != callGraphRankB) {
+                        return callGraphRankA < callGraphRankB;
+                    }
+                }
+                return packed && a.section->header.alignment() > b.section->header.alignment();
+            });
+        }
+        dword offset = 0;
+        for (auto& objSection : section.objSections) {
+            dword alignment = objSection.section->header.alignment();
+            offset = (offset + alignment - 1) & ~(alignment - 1);
+            objSection.offset = offset;
+            offset += objSection.section->header.sizeOfRawData;
+        }
+        section.size = offset;
+    };
+
+    // with the call graph and -stats, calls to another page are counted for the order without it and with it
+    // (node positions are offsets in their output section, output sections start on separate pages).
+    // code object sections can be merged into any output section, so positions are recorded in all of them
+    std::vector<ObjectCallGraph::NodePosition> nodePositionsBefore(callGraph.nodeCount());
+    std::vector<ObjectCallGraph::NodePosition> nodePositionsAfter(callGraph.nodeCount());
+    auto recordNodePositions = [&](const Section& section, int sectionNr, std::vector<ObjectCallGraph::NodePosition>& positions) {
+        for (auto& objSection : section.objSections) {
+            ObjectCallGraph::NodePosition position{sectionNr, static_cast<dword>(objSection.offset)};
+            callGraph.recordPosition(objSection.objNr, objSection.section - objSection.obj->sections.data(), position, positions);
+        }
+    };
+    int sectionNr = 0;
+    for (auto& sectionMapEntry : sectionsMap) {
+        auto& section = sectionMapEntry.second;
+        if (options.callGraphOrder && options.showStats) {
+            orderAndPlace(section, false);
+            recordNodePositions(section, sectionNr, nodePositionsBefore);
+            orderAndPlace(section, true);
+            recordNodePositions(section, sectionNr, nodePositionsAfter);
+        } else {
+            orderAndPlace(section, options.callGraphOrder);
+        }
+        sectionNr += 1;
+    }
+    if (options.callGraphOrder && options.showStats) {
+        std::cout << "call graph: " << callGraph.nodeCount() << " code sections, " << callGraph.edgeCount() << " call edges, "
+                  << "cross-page calls: " << callGraph.crossPageCalls(nodePositionsBefore, getPageSize()) << " -> "
+                  << callGraph.crossPageCalls(nodePositionsAfter, getPageSize()) << "\n";
+    }
+
     // sort sections to group as such: [code sections, initialized data sections, uninitialized data sections] 
     std::vector<Section> sections;
     for (auto& sectionMapEntry : sectionsMap) {
-        sections.push_back(sectionMapEntry.second);
+        sections.push_back(std::move(sectionMapEntry.second));
     }
     std::sort(begin(sections), end(sections));
 
     int maxNumberOfSections = sections.size() + 2; // maybe will add sections for imports and dll jumps (+2)
-    int sizeOfHeadersInFile = DosHeader::Size() + PeHeader::Size32() + SectionHeader::Size() * maxNumberOfSections;
+    int sizeOfHeadersInFile = DosHeader::Size() + Target::peHeaderSize() + SectionHeader::Size() * maxNumberOfSections;
     int sizeOfHeaders = options.fileAllign * ((sizeOfHeadersInFile / options.fileAllign) + 1); 
     int rawAddress = sizeOfHeaders;
     int virtualAddress = options.sectionAllign * ((sizeOfHeaders / options.sectionAllign) + 1);
@@ -381,23 +720,26 @@ std::optional<PeFile> createPeFromObj(const std::vector<ObjectFile>& objFiles, P
     dword baseOfData = 0;
 
     auto& peSections = peFile.sections;
-    std::unordered_map<ObjectSectionName, PeSectionPosition> objSectionNameToPeSection;
+    std::vector<std::vector<PeSectionPosition>> objSectionPositions(objFiles.size()); // for every section of every object file
+    for (size_t objNr = 0; objNr < objFiles.size(); ++objNr) {
+        objSectionPositions[objNr].resize(objFiles[objNr].sections.size());
+    }
     for (auto& section : sections) {
         peSections.emplace_back();
         auto& peSection = peSections.back();
         peSection.header.name = section.name;
-        peSection.header.characteristics = section.characteristics;
-        peSection.header.virtualSize = std::max<dword>(4, section.data.size());
+        peSection.header.characteristics = section.characteristics & ~SectionHeader::Characteristic::AllignMask; // alignment is only valid in object files
+        peSection.header.virtualSize = std::max<dword>(4, section.size);
         if (section.characteristics & SectionHeader::Characteristic::ContainsUninitializedData) {
             peSection.header.sizeOfRawData = 0;
             peSection.header.pointerToRawData = 0;
         } else {
-            peSection.header.sizeOfRawData = ((section.data.size() / options.fileAllign) + 1) * options.fileAllign;
+            peSection.header.sizeOfRawData = ((section.size / options.fileAllign) + 1) * options.fileAllign;
             peSection.header.pointerToRawData = rawAddress;
             rawAddress += peSection.header.sizeOfRawData;
         }
         peSection.header.virtualAddress = virtualAddress;
-        auto allignedVirtualSize = ((section.data.size() / options.sectionAllign) + 1) * options.sectionAllign;
+        auto allignedVirtualSize = ((section.size / options.sectionAllign) + 1) * options.sectionAllign;
         virtualAddress += allignedVirtualSize;
 
         peSection.header.pointerToRelocations = 0;
@@ -406,12 +748,11 @@ std::optional<PeFile> createPeFromObj(const std::vector<ObjectFile>& objFiles, P
         peSection.header.numberOfLineNumbers = 0;
 
         for (auto& objSection : section.objSections) {
-            objSectionNameToPeSection.emplace(ObjectSectionName(objSection.obj, section.name), PeSectionPosition(peSections.size()-1, objSection.offset));
-        }
-        
-        if (!(section.characteristics & SectionHeader::Characteristic::ContainsUninitializedData)) {
-            peSection.data = section.data;
+            objSectionPositions[objSection.objNr][objSection.section - objSection.obj->sections.data()] = PeSectionPosition(peSections.size()-1, objSection.offset);
         }
+        auto& contents = layout.sectionContents.emplace_back();
+        contents.size = section.size;
+        contents.objSections = std::move(section.objSections);
 
         if (section.characteristics & SectionHeader::Characteristic::ContainsCode) {
             sizeOfCode += peSection.header.sizeOfRawData;
@@ -423,81 +764,129 @@ std::optional<PeFile> createPeFromObj(const std::vector<ObjectFile>& objFiles, P
         }
     }
 
-    std::unordered_map<std::string, PeSectionPosition> symbolNameToPeSection;
-    for (auto& obj : objFiles) {
-        for (auto& symbol : obj.symbolTableEntries) {
-            if (std::holds_alternative<StandardSymbol>(symbol)) {
-                auto& standardSymbol = std::get<StandardSymbol>(symbol);
-                if (standardSymbol.storageClass == StandardSymbol::StorageClass::External && standardSymbol.sectionNumber > 0) {
-                    auto position = objSectionNameToPeSection.at(ObjectSectionName(&obj, obj.sections[standardSymbol.sectionNumber-1].header.name));
-                    position.offset += standardSymbol.value;
-                    auto symbolName = getSymbolName(standardSymbol.name, obj.stringTable);
-                    if (!symbolName) {
-                        return errorMessageOpt("obj file is malformed - missing string table entry");
-                    }
-                    if (auto foundSymbol = symbolNameToPeSection.find(*symbolName); foundSymbol != end(symbolNameToPeSection)) {
-                        return errorMessageOpt("multiple global symbols with same name: '" + foundSymbol->first + "'");
+    // global symbols of every object file are inserted by a separate task
+    ConcurrentSymbolTable<PeSectionPosition> symbolNameToPeSection; // keyed by interned symbol name
+    std::vector<size_t> definedSymbolCounts(objFiles.size(), 0);
+    parallelFor(objFiles.size(), options.threadCount, [&](size_t objNr) {
+        forEachDefinedExternal(objFiles[objNr], [&](size_t, size_t) {
+            definedSymbolCounts[objNr] += 1;
+        });
+    });
+    symbolNameToPeSection.reserve(std::accumulate(begin(definedSymbolCounts), end(definedSymbolCounts), size_t(0)));
+    parallelFor(objFiles.size(), options.threadCount, [&](size_t objNr) {
+        auto& obj = objFiles[objNr];
+        forEachDefinedExternal(obj, [&](size_t symbolIndex, size_t sectionIndex) {
+            auto position = objSectionPositions[objNr][sectionIndex];
+            position.offset += obj.symbolTable.value(symbolIndex);
+            symbolNameToPeSection.insert(obj.symbolNameIds[symbolIndex], {static_cast<dword>(objNr), static_cast<dword>(symbolIndex)}, position);
+        });
+    });
+    if (auto duplicate = symbolNameToPeSection.firstDuplicate()) {
+        return errorMessageOpt("multiple global symbols with same name: '" + std::string(SymbolInterner::global().name(*duplicate)) + "'");
+    }
+
+    // resolve symbols referenced by relocations, one object file per task. External symbols that
+    // no object file defines are collected (in order of first use) to be imported from dlls
+    auto& resolvedSymbols = layout.resolvedSymbols;
+    resolvedSymbols.resize(objFiles.size());
+    std::vector<std::vector<dword>> undefinedSymbols(objFiles.size());
+    std::vector<std::string> resolveErrors(objFiles.size());
+    parallelFor(objFiles.size(), options.threadCount, [&](size_t objNr) {
+        auto& obj = objFiles[objNr];
+        auto& symbols = obj.symbolTable;
+        auto& resolved = resolvedSymbols[objNr];
+        resolved.resize(symbols.size());
+        std::vector<bool> referenced(symbols.size(), false);
+        for (auto& section : obj.sections) {
+            if (section.discarded) {
+                continue;
+            }
+            for (auto& reloc : section.relocationTable) {
+                auto symbolIndex = reloc.symbolTableIndex;
+                if (symbolIndex >= symbols.size() || symbols.isAuxiliary(symbolIndex)) {
+                    resolveErrors[objNr] = "obj file is malformed - relocation doesn't point to a symbol";
+                    return;
+                }
+                if (referenced[symbolIndex]) {
+                    continue;
+                }
+                referenced[symbolIndex] = true;
+
+                auto& target = resolved[symbolIndex];
+                word sectionNumber = symbols.sectionNumber(symbolIndex);
+                if (sectionNumber == StandardSymbol::SpecialSectionNumberValues::SymbolAbsolute) {
+                    target.kind = ResolvedTarget::Kind::Absolute;
+                    target.offset = symbols.value(symbolIndex);
+                } else if (symbols.storageClass(symbolIndex) == StandardSymbol::StorageClass::External) {
+                    if (auto definition = symbolNameToPeSection.find(obj.symbolNameIds[symbolIndex])) {
+                        target.kind = ResolvedTarget::Kind::Section;
+                        target.sectionNr = definition->sectionNr;
+                        target.offset = definition->offset;
+                    } else {
+                        undefinedSymbols[objNr].push_back(symbolIndex);
                     }
-                    symbolNameToPeSection.emplace(*symbolName, position);
+                } else if (sectionNumber > 0 && sectionNumber <= obj.sections.size() && !obj.sections[sectionNumber-1].discarded) {
+                    auto position = objSectionPositions[objNr][sectionNumber-1];
+                    target.kind = ResolvedTarget::Kind::Section;
+                    target.sectionNr = position.sectionNr;
+                    target.offset = position.offset + symbols.value(symbolIndex);
+                } else {
+                    resolveErrors[objNr] = "obj file is malformed - relocation points to a symbol outside of linked sections";
+                    return;
                 }
             }
         }
+    });
+    for (auto& error : resolveErrors) {
+        if (!error.empty()) {
+            return errorMessageOpt(error);
+        }
     }
 
+    // get all dll symbols
     ImportDirectory32 dllImports;
-    std::unordered_map<std::string, dword> dllFunctionToJmpAddress;
-    std::unordered_map<std::string, std::string> dllFunctionSymbolNameToRealName;
+    std::unordered_map<std::string, dword> dllFunctionToJmpAddress; // keyed by name of the function in dll
+    std::unordered_map<SymbolId, dword> dllSymbolToJmpAddress; // keyed by interned symbol name in obj files
     int jmpSectionVirtualAddress = options.sectionAllign;
+    for (size_t objNr = 0; objNr < objFiles.size(); ++objNr) {
+        auto& obj = objFiles[objNr];
+        for (auto symbolIndex : undefinedSymbols[objNr]) {
+            auto symbolId = obj.symbolNameIds[symbolIndex];
+            auto& target = resolvedSymbols[objNr][symbolIndex];
+            target.kind = ResolvedTarget::Kind::DllImport;
+            if (auto found = dllSymbolToJmpAddress.find(symbolId); found != end(dllSymbolToJmpAddress)) {
+                target.offset = found->second;
+                continue;
+            }
 
-    // get all dll symbols
-    for (auto& obj : objFiles) {
-        for (auto& section : obj.sections) {
-            for (auto& reloc : section.relocationTable) {
-                // get the section+offset in PE that coresponds to the section that needs relocation (.text)
-                auto [peChangedSectionNumber, changedOffsetInSection] = objSectionNameToPeSection.at({&obj, section.header.name});
-                auto& sectionToChange = peFile.sections[peChangedSectionNumber];
-                int changedRVA = sectionToChange.header.virtualAddress + changedOffsetInSection;
-                auto* dataToChangePtr = &sectionToChange.data[reloc.virtualAddress + changedOffsetInSection];
-            
-                // get name of the symbol name in obj file that the relocations points to (.bss or .data if section...)
-                auto& standardSymbol = std::get<StandardSymbol>(obj.symbolTableEntries[reloc.symbolTableIndex]);
-            
-                if (standardSymbol.storageClass == StandardSymbol::StorageClass::External) {
-                    auto objAddressedSymbolName = getSymbolName(standardSymbol.name, obj.stringTable);
-                    if (!objAddressedSymbolName) {
-                        return errorMessageOpt("obj file is malformed - missing string table entry");
-                    }
-
-                    if (auto foundSymbol = symbolNameToPeSection.find(*objAddressedSymbolName); foundSymbol == symbolNameToPeSection.end()) { // it is symbol from dll
-                        if (auto dll = tryFindDll(*objAddressedSymbolName, options.dlls, options.showDllWarnings)) {
-                            dllFunctionSymbolNameToRealName.emplace(*objAddressedSymbolName, dll->first);
-                            auto jmpAddress = dllFunctionToJmpAddress.find(dll->first);
-                            dword dllJmpAddress = jmpSectionVirtualAddress;
-                            if (jmpAddress != end(dllFunctionToJmpAddress)) {
-                                dllJmpAddress = jmpAddress->second;
-                            } else {
-                                dllJmpAddress = jmpSectionVirtualAddress + dllFunctionToJmpAddress.size() * 6;
-                                dllFunctionToJmpAddress.emplace(dll->first, dllJmpAddress);
-                                auto dllImport = std::find_if(begin(dllImports.dlls), end(dllImports.dlls), [&dllName = dll->second](ImportDll32& import){
-                                    return import.name == dllName;
-                                });
-                                if (dllImport != end(dllImports.dlls)) {
-                                    auto& importedFunction = dllImport->imports.emplace_back();
-                                    importedFunction.hintName.hint =0;
-                                    importedFunction.hintName.name = dll->first;
-                                } else {
-                                    auto& newImportedDll = dllImports.dlls.emplace_back();
-                                    auto& importedFunction = newImportedDll.imports.emplace_back();
-                                    newImportedDll.name = dll->second;
-                                    importedFunction.hintName.hint = 0;
-                                    importedFunction.hintName.name = dll->first;
-                                }
-                            }
-                        } else {
-                            return errorMessageOpt("symbol '" + *objAddressedSymbolName + "' was not defined in any .obj or dll");
-                        }
+            std::string objAddressedSymbolName(SymbolInterner::global().name(symbolId));
+            if (auto dll = tryFindDll(objAddressedSymbolName, options.dlls, options.showDllWarnings)) {
+                auto jmpAddress = dllFunctionToJmpAddress.find(dll->first);
+                dword dllJmpAddress = jmpSectionVirtualAddress;
+                if (jmpAddress != end(dllFunctionToJmpAddress)) {
+                    dllJmpAddress = jmpAddress->second;
+                } else {
+                    dllJmpAddress = jmpSectionVirtualAddress + dllFunctionToJmpAddress.size() * 6;
+                    dllFunctionToJmpAddress.emplace(dll->first, dllJmpAddress);
+                    auto dllImport = std::find_if(begin(dllImports.dlls), end(dllImports.dlls), [&dllName = dll->second](ImportDll32& import){
+                        return import.name == dllName;
+                    });
+                    if (dllImport != end(dllImports.dlls)) {
+                        auto& importedFunction = dllImport->imports.emplace_back();
+                        importedFunction.hintName.hint =0;
+                        importedFunction.hintName.name = dll->first;
+                    } else {
+                        auto& newImportedDll = dllImports.dlls.emplace_back();
+                        auto& importedFunction = newImportedDll.imports.emplace_back();
+                        newImportedDll.name = dll->second;
+                        importedFunction.hintName.hint = 0;
+                        importedFunction.hintName.name = dll->first;
                     }
                 }
+                dllSymbolToJmpAddress.emplace(symbolId, dllJmpAddress);
+                target.offset = dllJmpAddress;
+            } else {
+                return errorMessageOpt("symbol '" + objAddressedSymbolName + "' was not defined in any .obj or dll");
             }
         }
     }
@@ -518,16 +907,21 @@ std::optional<PeFile> createPeFromObj(const std::vector<ObjectFile>& objFiles, P
         virtualAddress += sizeOfDllJmpSectionInMemory;
         rawAddress += sizeOfDllJmpSectionInFile;
 
-        for (auto& entry : objSectionNameToPeSection) {
-            entry.second.sectionNr += 1;
-        }
-        for (auto& entry : symbolNameToPeSection) {
-            entry.second.sectionNr += 1;
+        for (auto& resolved : resolvedSymbols) {
+            for (auto& target : resolved) {
+                if (target.kind == ResolvedTarget::Kind::Section) {
+                    target.sectionNr += 1;
+                }
+            }
         }
+        symbolNameToPeSection.forEachValue([](PeSectionPosition& position) {
+            position.sectionNr += 1;
+        });
 
         peSections.emplace(begin(peSections));
+        layout.sectionContents.emplace(begin(layout.sectionContents));
         auto dllJmpSection = &peSections[0];
-        dllJmpSection->data.resize(dllFunctionToJmpAddress.size()*6);
+        dllJmpSection->data.resize(dllFunctionToJmpAddress.size()*6, 0);
         dllJmpSection->header.name = strToArray(".dlljmp");
         dllJmpSection->header.virtualSize = dllJmpSection->data.size();
         dllJmpSection->header.virtualAddress = jmpSectionVirtualAddress;
@@ -544,12 +938,16 @@ std::optional<PeFile> createPeFromObj(const std::vector<ObjectFile>& objFiles, P
 
         // .idata section (import + IAT directory)
         peSections.emplace_back();
+        layout.sectionContents.emplace_back();
         auto& idata = peSections.back();
         dllJmpSection = &peSections[0];
 
-        dword importAddressTableRVAOffset = (dllImports.dlls.size() + dllFunctionToJmpAddress.size())*4;
-        dword importLookupTableRVA = virtualAddress + (dllImports.dlls.size() + 1) * 20;
-        dword nameRVA = virtualAddress + (dllImports.dlls.size() + 1)*20 + (dllImports.dlls.size() + dllFunctionToJmpAddress.size())*8;
+        // import lookup and address tables follow the directory entries (20 bytes each, plus the null one), aligned
+        // to the size of their entries - the loader writes the IAT entries and the jmps read them
+        dword importTablesOffset = ((dllImports.dlls.size() + 1)*20 + sizeof(Address) - 1) & ~(sizeof(Address) - 1);
+        dword importAddressTableRVAOffset = (dllImports.dlls.size() + dllFunctionToJmpAddress.size())*sizeof(Address);
+        dword importLookupTableRVA = virtualAddress + importTablesOffset;
+        dword nameRVA = virtualAddress + importTablesOffset + (dllImports.dlls.size() + dllFunctionToJmpAddress.size())*2*sizeof(Address);
         for (auto& dll : dllImports.dlls) {
             dll.directoryEntry.importLookupTableRVA = importLookupTableRVA;
             dll.directoryEntry.importAddressTableRVA = importLookupTableRVA + importAddressTableRVAOffset;
@@ -557,22 +955,21 @@ std::optional<PeFile> createPeFromObj(const std::vector<ObjectFile>& objFiles, P
                 importedFunction.hintNameTableRva = nameRVA;
                 nameRVA += importedFunction.hintName.name.size() + 3;
                 int pos = dllFunctionToJmpAddress.at(importedFunction.hintName.name)-jmpSectionVirtualAddress;
-                *reinterpret_cast<word*>(&dllJmpSection->data[pos]) = 0x25ff;
-                *reinterpret_cast<dword*>(&dllJmpSection->data[pos+2]) = options.imageBase + importLookupTableRVA + importAddressTableRVAOffset;
-                importLookupTableRVA += sizeof(dword);
+                Target::writeJmp(&dllJmpSection->data[pos], jmpSectionVirtualAddress + pos, importLookupTableRVA + importAddressTableRVAOffset, options.imageBase);
+                importLookupTableRVA += sizeof(Address);
             }
             dll.directoryEntry.nameRVA = nameRVA;
             nameRVA += dll.name.size()+1;
             dll.directoryEntry.forwarderChain = 0;
             dll.directoryEntry.timeDateStamp = 0;
-            importLookupTableRVA += sizeof(dword);
+            importLookupTableRVA += sizeof(Address);
         }
         int sizeOfImportSection = nameRVA - virtualAddress;
     
         importDataDirectory.size = sizeOfImportSection;
         importDataDirectory.virtualAddress = virtualAddress;
         importAddressTableDirectory.size = importAddressTableRVAOffset;
-        importAddressTableDirectory.virtualAddress = virtualAddress + (dllImports.dlls.size() + 1) * 20;
+        importAddressTableDirectory.virtualAddress = virtualAddress + importTablesOffset;
 
         idata.header.name = strToArray(".idata");
         idata.header.virtualSize = sizeOfImportSection;
@@ -601,9 +998,9 @@ std::optional<PeFile> createPeFromObj(const std::vector<ObjectFile>& objFiles, P
             }
             int offset = 0;
             for (auto& importedFunction : dll.imports) {
-                *reinterpret_cast<dword*>(&idata.data[dll.directoryEntry.importLookupTableRVA - virtualAddress + offset])  = importedFunction.hintNameTableRva;
-                *reinterpret_cast<dword*>(&idata.data[dll.directoryEntry.importAddressTableRVA - virtualAddress + offset]) = importedFunction.hintNameTableRva;
-                offset += sizeof(dword);
+                *reinterpret_cast<Address*>(&idata.data[dll.directoryEntry.importLookupTableRVA - virtualAddress + offset])  = importedFunction.hintNameTableRva;
+                *reinterpret_cast<Address*>(&idata.data[dll.directoryEntry.importAddressTableRVA - virtualAddress + offset]) = importedFunction.hintNameTableRva;
+                offset += sizeof(Address);
                 for (size_t i = 0; i < importedFunction.hintName.name.size(); ++i) {
                     idata.data[importedFunction.hintNameTableRva - virtualAddress + 2 + i] = importedFunction.hintName.name[i];
                 }
@@ -617,105 +1014,43 @@ std::optional<PeFile> createPeFromObj(const std::vector<ObjectFile>& objFiles, P
     }
     
 
-    // apply relocations
-    for (auto& obj : objFiles) {
-        for (auto& section : obj.sections) {
-            for (auto& reloc : section.relocationTable) {
-                // get the section+offset in PE that coresponds to the section that needs relocation
-                auto [peChangedSectionNumber, changedOffsetInSection] = objSectionNameToPeSection.at({&obj, section.header.name});
-                auto& sectionToChange = peFile.sections[peChangedSectionNumber];
-                int changedRVA = sectionToChange.header.virtualAddress + changedOffsetInSection;
-                auto* dataToChangePtr = &sectionToChange.data[reloc.virtualAddress + changedOffsetInSection];
-            
-                // get name of the symbol name in obj file that the relocations points to
-                auto& standardSymbol = std::get<StandardSymbol>(obj.symbolTableEntries[reloc.symbolTableIndex]);
-            
-                if (standardSymbol.storageClass != StandardSymbol::StorageClass::External) {
-                    // get the section+offset in PE that coresponds to the objAddressedSection
-                    auto objAddressedSymbolName = arrayToStr(standardSymbol.name);
-                    auto [peAddressedSectionNumber, addressedOffsetInSection] = objSectionNameToPeSection.at({&obj, strToArray(objAddressedSymbolName)});
-                    auto& addressedSection = peFile.sections[peAddressedSectionNumber];
-                    int addressedRVA = addressedSection.header.virtualAddress + addressedOffsetInSection;
-                
-                    if (reloc.type == RelocationEntry::TypeIntel386::Dir32va) {
-                        *reinterpret_cast<int*>(dataToChangePtr) += addressedRVA + options.imageBase;
-                    } else if (reloc.type == RelocationEntry::TypeIntel386::Dir32rva) {
-                        *reinterpret_cast<int*>(dataToChangePtr) += addressedRVA;
-                    } else if (reloc.type == RelocationEntry::Rel32) {
-                        *reinterpret_cast<int*>(dataToChangePtr) += addressedRVA - changedRVA - 5 - (reloc.virtualAddress - 1);
-                    } else if (reloc.type != RelocationEntry::Absolute) {
-                        return errorMessageOpt("unsuported relocation entry type");
-                    }
-                } else if (standardSymbol.storageClass == StandardSymbol::StorageClass::External) {
-                    auto objAddressedSymbolName = getSymbolName(standardSymbol.name, obj.stringTable);
-                    if (!objAddressedSymbolName) {
-                        return errorMessageOpt("obj file is malformed - missing string table entry");
-                    }
-
-                    if (auto foundSymbol = symbolNameToPeSection.find(*objAddressedSymbolName); foundSymbol != symbolNameToPeSection.end()) { // it is symbol from other obj
-                        auto peAddressedSymbolNumber = foundSymbol->second.sectionNr;
-                        auto addressedOffsetInSection = foundSymbol->second.offset;
-                        auto& addressedSection = peFile.sections[peAddressedSymbolNumber];
-                        int addressedRVA = addressedSection.header.virtualAddress + addressedOffsetInSection;
-
-                        if (reloc.type == RelocationEntry::TypeIntel386::Dir32va) {
-                            *reinterpret_cast<int*>(dataToChangePtr) += addressedRVA + options.imageBase;
-                        } else if (reloc.type == RelocationEntry::TypeIntel386::Dir32rva) {
-                            *reinterpret_cast<int*>(dataToChangePtr) += addressedRVA;
-                        } else if (reloc.type == RelocationEntry::Rel32) {
-                            *reinterpret_cast<int*>(dataToChangePtr) += addressedRVA - changedRVA - 5 - (reloc.virtualAddress - 1);
-                        } else if (reloc.type != RelocationEntry::Absolute) {
-                            return errorMessageOpt("unsuported relocation entry type");
-                        }
-                    } else { // it is symbol from dll
-                        auto dllJmpAddress = dllFunctionToJmpAddress.at(dllFunctionSymbolNameToRealName.at(*objAddressedSymbolName));
-                        if (reloc.type == RelocationEntry::TypeIntel386::Dir32va) {
-                            *reinterpret_cast<int*>(dataToChangePtr) = dllJmpAddress + options.imageBase;
-                        } else if (reloc.type == RelocationEntry::TypeIntel386::Dir32rva) {
-                            *reinterpret_cast<int*>(dataToChangePtr) = dllJmpAddress;
-                        } else if (reloc.type == RelocationEntry::Rel32) {
-                            *reinterpret_cast<int*>(dataToChangePtr) = dllJmpAddress - changedRVA - 5 - (reloc.virtualAddress - 1);
-                        } else if (reloc.type != RelocationEntry::Absolute) {
-                            return errorMessageOpt("unsuported relocation entry type");
-                        }
-                    }
-                }
-            }
-        }
-    }
-
     // find and set entry point
-    auto entryPoint = symbolNameToPeSection.find(options.entryPoint);
-    if (entryPoint == end(symbolNameToPeSection)) {
-        return errorMessageOpt("couldn't find entry point: '"+options.entryPoint+"'");
+    std::string entryPointName = options.entryPoint.empty() ? Target::DefaultEntryPoint : options.entryPoint;
+    auto entryPointId = SymbolInterner::global().find(entryPointName);
+    auto entryPoint = entryPointId ? symbolNameToPeSection.find(*entryPointId) : nullptr;
+    if (!entryPoint) {
+        return errorMessageOpt("couldn't find entry point: '"+entryPointName+"'");
     }
-    int addressOfEntryPoint = peSections[entryPoint->second.sectionNr].header.virtualAddress + entryPoint->second.offset;
+    int addressOfEntryPoint = peSections[entryPoint->sectionNr].header.virtualAddress + entryPoint->offset;
     
 
     // fileHeader
     auto& fileHeader = peFile.peHeader.fileHeader;
 
-    fileHeader.machine = FileHeader::Machine::I386;
+    fileHeader.machine = Target::Machine;
     fileHeader.numberOfSections = static_cast<word>(peSections.size());
     fileHeader.timeDateStamp = static_cast<dword>(time(nullptr));
     fileHeader.pointerToSymbolTable = 0;
     fileHeader.numberOfSymbols = 0;
-    fileHeader.sizeOfOptionalHeader = OptionalHeader32::Size();
+    fileHeader.sizeOfOptionalHeader = Target::OptionalHeader::Size();
     fileHeader.characteristics = FileHeader::Characteristic::RelocsStripped
                                | FileHeader::Characteristic::ExecutableImage
-                               | FileHeader::Characteristic::Machine32Bit
+                               | Target::Characteristics
                                | FileHeader::Characteristic::DebugStripped;
 
     // optional header
-    peFile.peHeader.optionalHeader = OptionalHeader32();
-    auto& optionalHeader = std::get<OptionalHeader32>(peFile.peHeader.optionalHeader);
+    using OptionalHeader = typename Target::OptionalHeader;
+    peFile.peHeader.optionalHeader = OptionalHeader();
+    auto& optionalHeader = std::get<OptionalHeader>(peFile.peHeader.optionalHeader);
 
     optionalHeader.sizeOfCode = sizeOfCode;
     optionalHeader.sizeOfInitializedData = sizeOfInitializedData;
     optionalHeader.sizeOfUninitializedData = sizeOfUninitializedData;
     optionalHeader.addressOfEntryPoint = addressOfEntryPoint;
     optionalHeader.baseOfCode = peSections[0].header.virtualAddress;
-    optionalHeader.baseOfData = baseOfData;
+    if constexpr (std::is_same_v<OptionalHeader, OptionalHeader32>) {
+        optionalHeader.baseOfData = baseOfData; // PE32+ has no base of data
+    }
     optionalHeader.imageBase = options.imageBase;
     optionalHeader.sectionAlignment = options.sectionAllign;
     optionalHeader.fileAlignment = options.fileAllign;
@@ -744,13 +1079,283 @@ std::optional<PeFile> createPeFromObj(const std::vector<ObjectFile>& objFiles, P
         optionalHeader.dataDirectories[i].size = 0;
         optionalHeader.dataDirectories[i].virtualAddress = 0;
     }
-    optionalHeader.dataDirectories[OptionalHeader32::DataDirectoryTableId::Import] = importDataDirectory;
-    optionalHeader.dataDirectories[OptionalHeader32::DataDirectoryTableId::IAT] = importAddressTableDirectory;
+    optionalHeader.dataDirectories[OptionalHeader::DataDirectoryTableId::Import] = importDataDirectory;
+    optionalHeader.dataDirectories[OptionalHeader::DataDirectoryTableId::IAT] = importAddressTableDirectory;
+
+    return layout;
+}
+
+/*
+    Applies relocations of one object section (part of section number sectionNr of the laid out PE file)
+    to its contents. sectionData is the contents of the whole PE section - only the object section's own part of it
+    is changed, so different object sections can be relocated at the same time.
+*/
+template<typename Traits> bool relocateObjectSection(const PeLayout& layout, size_t sectionNr, const ObjectSectionOffset& objSection, byte* sectionData) {
+    using Engine = RelocationEngine<Traits>;
+    thread_local Engine engine;
+    engine.clear();
+
+    auto& peFile = layout.peFile;
+    auto& resolvedSymbols = layout.resolvedSymbols[objSection.objNr];
+    int changedOffsetInSection = objSection.offset;
+    int changedRVA = peFile.sections[sectionNr].header.virtualAddress + changedOffsetInSection;
+    dword objSectionSize = objSection.section->header.sizeOfRawData;
+    for (auto& reloc : objSection.section->relocationTable) {
+        if (reloc.type == Traits::Ignored) {
+            continue;
+        }
+        int kernel = Engine::kernelIndex(reloc.type);
+        if (kernel < 0) {
+            return errorMessageBool("unsuported relocation entry type");
+        }
+        if (reloc.virtualAddress > objSectionSize || objSectionSize - reloc.virtualAddress < Engine::patchSize(kernel)) {
+            return errorMessageBool("obj file is malformed - relocation outside of its section");
+        }
+        dword offset = reloc.virtualAddress + changedOffsetInSection;
+
+        // symbols of every relocation were resolved (and checked) during layout
+        auto& target = resolvedSymbols[reloc.symbolTableIndex];
+        qword addressedRVA = 0; // absolute targets below the image base wrap around, so they must not be truncated to a dword
+        if (target.kind == ResolvedTarget::Kind::Section) {
+            addressedRVA = peFile.sections[target.sectionNr].header.virtualAddress + target.offset;
+        } else if (target.kind == ResolvedTarget::Kind::DllImport) {
+            addressedRVA = target.offset;
+            memset(sectionData + offset, 0, Engine::patchSize(kernel)); // set to the jmp address, not added to it
+        } else if (target.kind == ResolvedTarget::Kind::Absolute) {
+            addressedRVA = target.offset - static_cast<qword>(layout.imageBase);
+        } else {
+            return errorMessageBool("relocation points to unresolved symbol");
+        }
+        engine.add(kernel, offset, addressedRVA, changedRVA + reloc.virtualAddress);
+    }
+
+    engine.apply(sectionData, layout.imageBase);
+    return true;
+}
+
+/*
+    Microbenchmark of relocation kernels: applies relocations of all object sections rounds times on one thread
+    (to zero filled scratch copies of the sections, no section data is read) and prints how many were applied per second.
+*/
+template<typename Target> bool benchmarkRelocations(const PeLayout& layout, int rounds) {
+    size_t relocationCount = 0;
+    std::chrono::steady_clock::duration time{};
+    std::vector<byte> sectionData;
+    for (size_t sectionNr = 0; sectionNr < layout.sectionContents.size(); ++sectionNr) {
+        auto& contents = layout.sectionContents[sectionNr];
+        if (contents.objSections.empty() || (layout.peFile.sections[sectionNr].header.characteristics & SectionHeader::Characteristic::ContainsUninitializedData)) {
+            continue;
+        }
+        sectionData.assign(contents.size, 0);
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; ++round) {
+            for (auto& objSection : contents.objSections) {
+                if (!relocateObjectSection<typename Target::Relocation>(layout, sectionNr, objSection, sectionData.data())) {
+                    return false;
+                }
+            }
+        }
+        time += std::chrono::steady_clock::now() - start;
+        for (auto& objSection : contents.objSections) {
+            relocationCount += objSection.section->relocationTable.size() * rounds;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(time).count();
+    std::cout << "relocation benchmark: " << relocationCount << " relocations in " << seconds * 1000 << " ms ("
+              << (seconds > 0 ? relocationCount / seconds / 1e6 : 0.0) << " million per second)\n";
+    return true;
+}
+
+/*
+    Writes contents of section number sectionNr of the laid out PE file (object sections data with applied
+    relocations) to sectionData, which has to be at least sectionContents[sectionNr].size bytes long. All of these bytes
+    are written (object sections without data in the file are zero filled, gaps left for alignment are padded),
+    so sectionData doesn't have to be initialized.
+    Every object section is read, relocated and padded before by a separate task (on up to threadCount threads) -
+    it only touches its own part of sectionData, so no locking is needed. Only reads the layout, so different sections can be filled at the same time.
+*/
+template<typename Target> bool fillPeSection(const PeLayout& layout, size_t sectionNr, byte* sectionData, int threadCount=1) {
+    if (layout.peFile.sections[sectionNr].header.characteristics & SectionHeader::Characteristic::ContainsUninitializedData) {
+        return true;
+    }
+    bool code = layout.peFile.sections[sectionNr].header.characteristics & SectionHeader::Characteristic::ContainsCode;
+    auto& objSections = layout.sectionContents[sectionNr].objSections;
+    std::atomic<bool> success = true;
+    parallelFor(objSections.size(), threadCount, [&](size_t i) {
+        auto& objSection = objSections[i];
+        size_t paddingStart = i == 0 ? 0 : objSections[i-1].offset + objSections[i-1].section->header.sizeOfRawData;
+        fillPadding(sectionData + paddingStart, objSection.offset - paddingStart, code, layout.codePadding);
+        if (objSection.section->header.characteristics & SectionHeader::Characteristic::ContainsUninitializedData) {
+            memset(sectionData + objSection.offset, 0, objSection.section->header.sizeOfRawData);
+        } else if (!readSectionData(*objSection.obj, *objSection.section, sectionData + objSection.offset)) {
+            success = errorMessageBool("couldn't read section data of obj file");
+        } else if (!relocateObjectSection<typename Target::Relocation>(layout, sectionNr, objSection, sectionData)) {
+            success = false;
+        }
+    });
+    return success;
+}
+
+/*
+    Fills contents of all sections of the laid out PE file in memory (PeSection::data), on up to threadCount threads.
+*/
+template<typename Target> std::optional<PeFile> createPeFromObj(PeLayout layout, int threadCount) {
+    auto& peSections = layout.peFile.sections;
+    for (size_t i = 0; i < peSections.size(); ++i) {
+        auto& contents = layout.sectionContents[i];
+        if (contents.objSections.empty() || (peSections[i].header.characteristics & SectionHeader::Characteristic::ContainsUninitializedData)) {
+            continue;
+        }
+        peSections[i].data.resize(contents.size);
+        if (!fillPeSection<Target>(layout, i, peSections[i].data.data(), threadCount)) {
+            return std::nullopt;
+        }
+    }
+    return std::move(layout.peFile);
+}
+
+/*
+    Streaming link: writes the laid out PE file one section at a time. Data of the object sections is read
+    from the object files straight into the buffer of the section being produced, relocated there and written out.
+    Object files are released as soon as no later section needs them, so besides one output section
+    only the metadata of the remaining object files is in memory.
+*/
+template<typename Target> bool writePeStreaming(const PeLayout& layout, std::vector<ObjectFile>& objFiles, GatherOutputFile& out, int threadCount) {
+    auto& peSections = layout.peFile.sections;
+
+    auto headers = serializeHeaders(layout.peFile);
+    if (!headers || !out.write({ByteSpan(headers->data(), headers->size())}, 0)) {
+        return false;
+    }
+
+    // last section that needs each object file (its relocations and symbols)
+    std::vector<size_t> lastSectionNrUsingObj(objFiles.size(), 0);
+    for (size_t sectionNr = 0; sectionNr < peSections.size(); ++sectionNr) {
+        for (auto& objSection : layout.sectionContents[sectionNr].objSections) {
+            lastSectionNrUsingObj[objSection.obj - objFiles.data()] = sectionNr;
+        }
+    }
+
+    SectionData sectionData;
+    for (size_t sectionNr = 0; sectionNr < peSections.size(); ++sectionNr) {
+        auto& peSection = peSections[sectionNr];
+        auto& contents = layout.sectionContents[sectionNr];
+        if (peSection.header.sizeOfRawData > 0) {
+            // contents are written once, only the padding after them is zeroed
+            sectionData.resize(peSection.header.sizeOfRawData);
+            size_t contentsSize = contents.size;
+            if (contents.objSections.empty()) {
+                if (peSection.data.size() > sectionData.size()) {
+                    return false;
+                }
+                std::copy(peSection.data.begin(), peSection.data.end(), sectionData.begin());
+                contentsSize = peSection.data.size();
+            } else {
+                if (contentsSize > sectionData.size() || !fillPeSection<Target>(layout, sectionNr, sectionData.data(), threadCount)) {
+                    return false;
+                }
+            }
+            std::fill(sectionData.begin() + contentsSize, sectionData.end(), 0);
+            if (!out.write({ByteSpan(sectionData.data(), sectionData.size())}, peSection.header.pointerToRawData)) {
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < objFiles.size(); ++i) {
+            if (lastSectionNrUsingObj[i] == sectionNr) {
+                objFiles[i] = ObjectFile();
+            }
+        }
+    }
+
+    return true;
+}
+
+
+std::optional<ObjectFile> readInputObjectFile(const std::string& objFileName, InputReader inputReader) {
+    switch (inputReader) {
+    case InputReader::Buffered: return readObjectFile<BufferedBinaryFile>(objFileName);
+    case InputReader::Stream:   return readObjectFile<BinaryFile>(objFileName);
+    default:                    return readObjectFile<MappedFile>(objFileName);
+    }
+}
 
-    return peFile;
+/*
+    Reads relocations of all sections of the object files that become part of the image
+    (in parallel, one object file per thread).
+*/
+bool loadRelocations(std::vector<ObjectFile>& objFiles, const std::vector<std::string>& objFileNames, int threadCount) {
+    std::vector<char> loaded(objFiles.size(), false);
+    parallelFor(objFiles.size(), threadCount, [&](size_t i) {
+        bool success = true;
+        for (auto& section : objFiles[i].sections) {
+            if (!section.discarded) {
+                success = success && loadRelocations(objFiles[i], section);
+            }
+        }
+        loaded[i] = success;
+    });
+    for (size_t i = 0; i < objFiles.size(); ++i) {
+        if (!loaded[i]) {
+            return errorMessageBool("couldn't read relocations in obj file '" + objFileNames[i] + "'");
+        }
+    }
+    return true;
 }
 
 
+/*
+    Lays out, fills and writes the PE image (Target - PeTarget32 or PeTarget64) made from the object files.
+    Returns exit code of the program (0 on success).
+*/
+template<typename Target> int linkPe(std::vector<ObjectFile>& objFiles, const ProgramOptions& options, int& writeSystemCallCount) {
+    // create PE file structure
+    auto peLayout = layoutPeFromObj<Target>(objFiles, options);
+    if (!peLayout) {
+        errorMessageOpt("creating PE file structure failed");
+        return 3;
+    }
+
+    if (options.relocationBenchmarkRounds > 0 && !benchmarkRelocations<Target>(*peLayout, options.relocationBenchmarkRounds)) {
+        return 3;
+    }
+
+    // create PE file
+    bool writeSuccess = false;
+    if (options.streaming) {
+        GatherOutputFile outFile(options.outputFileName);
+        writeSuccess = writePeStreaming<Target>(*peLayout, objFiles, outFile, options.threadCount);
+        writeSystemCallCount = outFile.getSystemCallCount();
+    } else if (options.outputWriter == OutputWriter::Mapped) {
+        // sections made from object files are filled (and relocated) directly in the mapped output file.
+        // sections are done one after another, with their object sections spread over the threads
+        writeSuccess = writeMapped(peLayout->peFile, options.outputFileName, 1, [&peLayout, &options](size_t sectionNr, byte* destination) {
+            auto& peSection = peLayout->peFile.sections[sectionNr];
+            if (peLayout->sectionContents[sectionNr].objSections.empty()) {
+                std::copy(peSection.data.begin(), peSection.data.end(), destination);
+                return true;
+            }
+            return fillPeSection<Target>(*peLayout, sectionNr, destination, options.threadCount);
+        });
+    } else if (options.outputWriter == OutputWriter::Gather) {
+        auto peFile = createPeFromObj<Target>(std::move(*peLayout), options.threadCount);
+        GatherOutputFile outFile(options.outputFileName);
+        writeSuccess = peFile && writeGathered(*peFile, outFile);
+        writeSystemCallCount = outFile.getSystemCallCount();
+    } else {
+        auto peFile = createPeFromObj<Target>(std::move(*peLayout), options.threadCount);
+        BinaryFile outFile(options.outputFileName, true);
+        writeSuccess = peFile && write(outFile, *peFile, options.outputFileName);
+    }
+    if (!writeSuccess) {
+        errorMessageOpt("creating PE file failed");
+        remove(options.outputFileName.c_str());
+        return 4;
+    }
+    return 0;
+}
+
 int main(int argc, char** argv) {
     // parse command line arguments
     auto optionsOpt = getProgramOptions(argv[0], std::vector<char*>(argv+1, argv+argc));
@@ -763,16 +1368,44 @@ int main(int argc, char** argv) {
         return 0;
     }
 
-    // read object files
+    // read object files (in parallel, every file parsed into its own slot, so the order stays the command line order)
+    auto parseStartTime = std::chrono::steady_clock::now();
+    std::vector<std::optional<ObjectFile>> parsedObjFiles(options.objFileNames.size());
+    if (options.prefetchDepth > 0) {
+        // next files are loaded by a background thread while the current ones are parsed from memory.
+        // loaded files are released right after parsing (contents are read from the files later, when needed),
+        // so prefetchBytes limits the memory taken by them
+        FilePrefetcher prefetcher(options.objFileNames, options.prefetchDepth, options.prefetchBytes);
+        parallelFor(options.threadCount, options.threadCount, [&](size_t) {
+            while (auto prefetchedFile = prefetcher.next()) {
+                if (!prefetchedFile->bytes) continue;
+                SpanReader reader(ByteSpan(prefetchedFile->bytes->data(), prefetchedFile->bytes->size()), prefetchedFile->name);
+                auto& objFileOpt = parsedObjFiles[prefetchedFile->index];
+                objFileOpt = readObjectFile(reader, prefetchedFile->name);
+                if (objFileOpt) {
+                    detachFromReadMemory(*objFileOpt, prefetchedFile->name);
+                }
+            }
+        });
+    } else {
+        parallelFor(options.objFileNames.size(), options.threadCount, [&](size_t i) {
+            parsedObjFiles[i] = readInputObjectFile(options.objFileNames[i], options.inputReader);
+        });
+    }
     std::vector<ObjectFile> objFiles;
-    for (auto& objFileName : options.objFileNames) {
-        auto objFileOpt = readObjectFile<BinaryFile>(objFileName);
-        if (!objFileOpt) {
-            errorMessageOpt("couldn't read object file '" + objFileName + "'");
+    objFiles.reserve(parsedObjFiles.size());
+    for (size_t i = 0; i < parsedObjFiles.size(); ++i) {
+        if (!parsedObjFiles[i]) {
+            errorMessageOpt("couldn't read object file '" + options.objFileNames[i] + "'");
             return 2;
         }
-        objFiles.emplace_back(*objFileOpt);
+        objFiles.emplace_back(std::move(*parsedObjFiles[i]));
     }
+    parsedObjFiles.clear();
+    if (!loadRelocations(objFiles, options.objFileNames, options.threadCount)) {
+        return 2;
+    }
+    auto parseTime = std::chrono::steady_clock::now() - parseStartTime;
 
     // load system dlls
     std::vector<std::string> dllNames = {
@@ -786,19 +1419,13 @@ int main(int argc, char** argv) {
         }
     }
 
-    // create PE file structure
-    auto peFile = createPeFromObj(objFiles, options);
-    if (!peFile) {
-        errorMessageOpt("creating PE file structure failed");
-        return 3;
-    }
-
-    // create PE file
-    BinaryFile outFile(options.outputFileName, true);
-    if (!write(outFile, *peFile, options.outputFileName)) {
-        errorMessageOpt("creating PE file failed");
-        remove(options.outputFileName.c_str());
-        return 4;
+    // link 32 or 64-bit image, depending on the machine type of the object files
+    bool link64 = std::any_of(begin(objFiles), end(objFiles), [](const ObjectFile& obj) {
+        return obj.fileHeader.machine == FileHeader::Machine::AMD64;
+    });
+    int writeSystemCallCount = 0;
+    if (int result = link64 ? linkPe<PeTarget64>(objFiles, options, writeSystemCallCount) : linkPe<PeTarget32>(objFiles, options, writeSystemCallCount)) {
+        return result;
     }
 
     // free loaded dlls
@@ -806,5 +1433,26 @@ int main(int argc, char** argv) {
         FreeLibrary(dll.second);
     }
 
+    if (options.showStats) {
+        std::cout << "parse time: " << std::chrono::duration_cast<std::chrono::microseconds>(parseTime).count() / 1000.0 << " ms\n";
+        std::cout << "section contents not read: " << SectionContentsStats::totalBytes - SectionContentsStats::readBytes
+                  << " of " << SectionContentsStats::totalBytes << " bytes\n";
+        size_t numberOfSymbols = 0;
+        size_t symbolTablesMemory = 0;
+        for (auto& obj : objFiles) {
+            numberOfSymbols += obj.symbolTable.size();
+            symbolTablesMemory += obj.symbolTable.memoryUsage();
+        }
+        std::cout << "symbol tables: " << numberOfSymbols << " records, " << symbolTablesMemory << " bytes ("
+                  << (numberOfSymbols ? static_cast<double>(symbolTablesMemory) / numberOfSymbols : 0.0) << " bytes per record)\n";
+        std::cout << "peak memory usage: " << getPeakMemoryUsage() / 1024 << " KiB\n";
+        if (options.inputReader == InputReader::Buffered || options.prefetchDepth > 0) {
+            std::cout << "read system calls: " << BufferedBinaryFile::getTotalSystemCallCount() + PositionalFile::getTotalSystemCallCount() << '\n';
+        }
+        if (options.streaming || options.outputWriter == OutputWriter::Gather) {
+            std::cout << "write system calls: " << writeSystemCallCount << '\n';
+        }
+    }
+
     return 0;
 }
\ No newline at end of file